@@ -33,4 +33,4 @@ cp src/cpp/*.hpp target/automake
 cd target/automake
 make
 cd ../..
-cp -rv target/automake/.libs target/automake/qqwing target/
+cp -rv target/automake/.libs target/automake/qqwing target/automake/qqwing-bench target/
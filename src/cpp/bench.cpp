@@ -0,0 +1,290 @@
+/*
+ * qqwing - Sudoku solver and generator
+ * Copyright (C) 2026 Stephen Ostermiller
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include "config.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#if HAVE_CLOCK_GETTIME == 1
+	#include <time.h>
+#elif HAVE_GETTIMEOFDAY == 1
+	#include <sys/time.h>
+#else
+	#include <time.h>
+#endif
+
+#include "qqwing.hpp"
+
+using namespace qqwing;
+using namespace std;
+
+/**
+ * The times taken by each puzzle for one
+ * operation on one corpus of puzzles.
+ */
+struct Benchmark {
+	string operation;
+	string corpus;
+	vector<long> nanoseconds;
+};
+
+long long getNanoseconds();
+bool readCorpus(const char* fileName, vector<int>* puzzles);
+string corpusName(const char* fileName);
+void benchmarkCorpus(const string& corpus, vector<int>& puzzles, int repeat, vector<Benchmark>* benchmarks);
+void benchmarkGenerate(int count, unsigned long seed, vector<Benchmark>* benchmarks);
+void printJson(const vector<Benchmark>& benchmarks, int repeat);
+void printHelp();
+
+enum Operation {SOLVE, COUNT_SOLUTIONS, RATE};
+
+/**
+ * Run each operation over each corpus of puzzles and print the
+ * timings as JSON, so that they can be compared between releases.
+ * Run with --help as an argument for usage.
+ */
+int main(int argc, char *argv[]){
+	try {
+		int repeat = 5;
+		int generateCount = 100;
+		unsigned long seed = 1;
+		vector<const char*> corpusFiles;
+
+		{for (int i=1; i<argc; i++){
+			if (!strcmp(argv[i],"--repeat") && i+1 < argc){
+				repeat = atoi(argv[++i]);
+				if (repeat <= 0){
+					cout << "Bad number of repeats: " << argv[i] << endl;
+					return 1;
+				}
+			} else if (!strcmp(argv[i],"--generate") && i+1 < argc){
+				generateCount = atoi(argv[++i]);
+				if (generateCount < 0){
+					cout << "Bad number of puzzles to generate: " << argv[i] << endl;
+					return 1;
+				}
+			} else if (!strcmp(argv[i],"--seed") && i+1 < argc){
+				seed = strtoul(argv[++i], NULL, 10);
+			} else if (!strcmp(argv[i],"-h") || !strcmp(argv[i],"--help")){
+				printHelp();
+				return 0;
+			} else if (argv[i][0] == '-'){
+				cout << "Unknown argument: '" << argv[i] << "'" << endl;
+				printHelp();
+				return 1;
+			} else {
+				corpusFiles.push_back(argv[i]);
+			}
+		}}
+
+		if (corpusFiles.empty()){
+			corpusFiles.push_back("test/bench/easy.txt");
+			corpusFiles.push_back("test/bench/17-clue.txt");
+			corpusFiles.push_back("test/bench/hardest.txt");
+		}
+
+		vector<Benchmark> benchmarks;
+		{for (unsigned int i=0; i<corpusFiles.size(); i++){
+			vector<int> puzzles;
+			if (!readCorpus(corpusFiles[i], &puzzles)){
+				cout << "Could not read puzzles from " << corpusFiles[i] << endl;
+				return 1;
+			}
+			benchmarkCorpus(corpusName(corpusFiles[i]), puzzles, repeat, &benchmarks);
+		}}
+		if (generateCount > 0) benchmarkGenerate(generateCount, seed, &benchmarks);
+
+		printJson(benchmarks, repeat);
+	} catch (char const* s){
+		cout << s <<  endl;
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Time each operation on every puzzle in the corpus, going
+ * through the whole corpus once to warm up and then the given
+ * number of times while timing.
+ */
+void benchmarkCorpus(const string& corpus, vector<int>& puzzles, int repeat, vector<Benchmark>* benchmarks){
+	const char* names[] = {"solve", "countSolutionsLimited", "rate"};
+	int count = puzzles.size()/BOARD_SIZE;
+	{for (int operation=SOLVE; operation<=RATE; operation++){
+		SudokuBoard* ss = new SudokuBoard();
+		ss->setRecordHistory(operation == RATE);
+		Benchmark benchmark;
+		benchmark.operation = names[operation];
+		benchmark.corpus = corpus;
+		{for (int pass=0; pass<=repeat; pass++){
+			{for (int i=0; i<count; i++){
+				long long start = getNanoseconds();
+				ss->setPuzzle(&puzzles[i*BOARD_SIZE]);
+				switch (operation){
+					case SOLVE:{
+						ss->solve();
+					} break;
+					case COUNT_SOLUTIONS:{
+						ss->countSolutionsLimited();
+					} break;
+					case RATE:{
+						ss->solve();
+						ss->getDifficulty();
+					} break;
+				}
+				long long done = getNanoseconds();
+				if (pass > 0) benchmark.nanoseconds.push_back((long)(done - start));
+			}}
+		}}
+		benchmarks->push_back(benchmark);
+		delete ss;
+	}}
+}
+
+/**
+ * Time generating puzzles from a fixed seed, so that the
+ * same puzzles are generated on every run.
+ */
+void benchmarkGenerate(int count, unsigned long seed, vector<Benchmark>* benchmarks){
+	SudokuBoard* ss = new SudokuBoard();
+	ss->setSeed(seed);
+	Benchmark benchmark;
+	benchmark.operation = "generatePuzzleSymmetry";
+	benchmark.corpus = "generated";
+	{for (int i=0; i<count; i++){
+		long long start = getNanoseconds();
+		ss->generatePuzzleSymmetry(SudokuBoard::NONE);
+		long long done = getNanoseconds();
+		benchmark.nanoseconds.push_back((long)(done - start));
+	}}
+	benchmarks->push_back(benchmark);
+	delete ss;
+}
+
+/**
+ * The time for the puzzle at the given fraction of the way
+ * through the sorted times (nearest rank).
+ */
+long percentile(const vector<long>& sorted, double fraction){
+	if (sorted.empty()) return 0;
+	int rank = (int)(fraction*sorted.size()+0.999999);
+	if (rank < 1) rank = 1;
+	return sorted[rank-1];
+}
+
+void printJson(const vector<Benchmark>& benchmarks, int repeat){
+	cout << "{" << endl;
+	cout << "  \"version\": \"" << getVersion() << "\"," << endl;
+	cout << "  \"repeat\": " << repeat << "," << endl;
+	cout << "  \"benchmarks\": [" << endl;
+	{for (unsigned int i=0; i<benchmarks.size(); i++){
+		const Benchmark& b = benchmarks[i];
+		vector<long> sorted = b.nanoseconds;
+		sort(sorted.begin(), sorted.end());
+		double total = 0;
+		{for (unsigned int j=0; j<sorted.size(); j++){
+			total += sorted[j];
+		}}
+		double seconds = total/1e9;
+		double puzzlesPerSecond = (total > 0) ? sorted.size()/seconds : 0;
+		double nanosecondsPerPuzzle = sorted.empty() ? 0 : total/sorted.size();
+		char line[512];
+		snprintf(line, sizeof(line),
+				"    {\"operation\": \"%s\", \"corpus\": \"%s\", \"puzzles\": %lu, \"seconds\": %.6f,"
+				" \"puzzles_per_second\": %.1f, \"ns_per_puzzle\": %.1f, \"p50_ns\": %ld, \"p99_ns\": %ld}%s",
+				b.operation.c_str(), b.corpus.c_str(), (unsigned long)sorted.size(), seconds,
+				puzzlesPerSecond, nanosecondsPerPuzzle, percentile(sorted, 0.50), percentile(sorted, 0.99),
+				(i+1 < benchmarks.size()) ? "," : "");
+		cout << line << endl;
+	}}
+	cout << "  ]" << endl;
+	cout << "}" << endl;
+}
+
+/**
+ * Read one puzzle per line: 81 digits, with a period or zero
+ * for each unknown.  Lines starting with # are comments.
+ */
+bool readCorpus(const char* fileName, vector<int>* puzzles){
+	ifstream in(fileName);
+	if (!in) return false;
+	string line;
+	while (getline(in, line)){
+		if (line.empty() || line[0] == '#') continue;
+		int read = 0;
+		{for (unsigned int i=0; i<line.size() && read<BOARD_SIZE; i++){
+			char c = line[i];
+			if (c >= '1' && c <='9'){
+				puzzles->push_back(c-'0');
+				read++;
+			} else if (c == '.' || c == '0'){
+				puzzles->push_back(0);
+				read++;
+			}
+		}}
+		if (read != BOARD_SIZE) return false;
+	}
+	return !puzzles->empty();
+}
+
+/**
+ * The name of the corpus in a file: the file name
+ * without any directory or extension.
+ */
+string corpusName(const char* fileName){
+	string name = fileName;
+	size_t slash = name.find_last_of('/');
+	if (slash != string::npos) name = name.substr(slash+1);
+	size_t dot = name.find_last_of('.');
+	if (dot != string::npos && dot > 0) name = name.substr(0, dot);
+	return name;
+}
+
+/**
+ * Get the current time in nanoseconds, from a
+ * monotonic clock where one is available.
+ */
+long long getNanoseconds(){
+	#if HAVE_CLOCK_GETTIME == 1
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return ((long long)now.tv_sec)*1000000000+now.tv_nsec;
+	#elif HAVE_GETTIMEOFDAY == 1
+		timeval tv;
+		gettimeofday(&tv, NULL);
+		return (((long long)tv.tv_sec)*1000000+tv.tv_usec)*1000;
+	#else
+		return ((long long)time(NULL))*1000000000;
+	#endif
+}
+
+void printHelp(){
+	cout << "qqwing-bench <options> [corpus files]" << endl;
+	cout << "Time solving, counting, rating, and generating Sudoku puzzles." << endl;
+	cout << "The results are printed as JSON.  The corpus files have one puzzle" << endl;
+	cout << "per line.  By default, the corpus files in test/bench are used." << endl;
+	cout << "  --repeat <num>       Times to go through each corpus (default 5)" << endl;
+	cout << "  --generate <num>     Puzzles to generate (default 100)" << endl;
+	cout << "  --seed <num>         Seed for generating puzzles (default 1)" << endl;
+	cout << "  --help               Print this message" << endl;
+}
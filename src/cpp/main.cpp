@@ -25,6 +25,8 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <set>
+#include <sstream>
 
 #if HAVE_GETTIMEOFDAY == 1
 	#include <sys/time.h>
@@ -32,13 +34,176 @@
 	#include <time.h>
 #endif
 
+#if HAVE_PTHREAD == 1
+	#include <pthread.h>
+#endif
+
+#if HAVE_UNISTD_H == 1
+	#include <unistd.h>
+#endif
+
+#if HAVE_MMAP == 1 && HAVE_SYS_MMAN_H == 1
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#define MAP_INPUT 1
+#endif
+
 #include "qqwing.hpp"
 
 using namespace qqwing;
 using namespace std;
 
+/**
+ * The longest line read from standard input at once.
+ * Longer lines are read in pieces.
+ */
+const int TEXT_LINE_SIZE = 4096;
+
+/**
+ * Text to parse puzzles from: either a whole file mapped
+ * into memory, so that puzzles can be parsed straight from
+ * it with no reads or copies, or standard input read a line
+ * at a time.
+ */
+struct TextInput {
+	/**
+	 * Where the next puzzle starts, and the end
+	 * of the text that is in memory.
+	 */
+	const char* next;
+	const char* end;
+
+	/**
+	 * The whole file, when it is mapped.
+	 */
+	bool mapped;
+	const char* data;
+	size_t size;
+
+	/**
+	 * Any squares left over from earlier lines of standard
+	 * input, followed by the line being parsed.
+	 */
+	char buffer[BOARD_SIZE+TEXT_LINE_SIZE];
+};
+
+/**
+ * The number of puzzles read from the input at a time
+ * when solving with threads.  With a seed, the board is
+ * seeded again for each batch, with or without threads.
+ */
+const int BATCH_SIZE = 256;
+
+/**
+ * The size of the buffer for standard output.
+ */
+const int OUTPUT_BUFFER_SIZE = 1<<16;
+
+/**
+ * Output kept in a buffer and written to standard output
+ * in large pieces, rather than a line or a square at a
+ * time.  Flushing a stream that writes to it (with endl,
+ * for example) writes nothing.  The buffer is written when
+ * it is full, after every so many puzzles if asked, and
+ * at the end.
+ */
+class OutputBuffer : public streambuf {
+	public:
+		/**
+		 * Write the buffer after every given number of
+		 * puzzles, or only when it is full if zero.
+		 */
+		OutputBuffer(int flushEvery);
+		~OutputBuffer();
+
+		/**
+		 * Note that the output for the given number of
+		 * puzzles has been added, writing the buffer if it
+		 * has been enough puzzles.
+		 */
+		void puzzlesDone(int count);
+		void writeBuffer();
+	protected:
+		virtual int_type overflow(int_type c);
+		virtual int sync();
+	private:
+		vector<char> buffer;
+		int flushEvery;
+		int puzzlesNotWritten;
+};
+
+/**
+ * The options that control how each puzzle
+ * is handled and what is printed for it.
+ */
+struct PuzzleOptions {
+	bool printPuzzle;
+	bool printSolution;
+	bool printHistory;
+	bool printInstructions;
+	bool timer;
+	bool countSolutions;
+	bool printStats;
+	bool logHistory;
+	bool profile;
+	int variants;
+	bool unique;
+	int cacheSize;
+	SudokuBoard::PrintStyle printStyle;
+	SudokuBoard::Difficulty difficulty;
+	SudokuBoard::Symmetry symmetry;
+
+	/**
+	 * Where to read puzzles in the binary format, or
+	 * NULL to read them as text from standard input.
+	 */
+	BinaryPuzzleReader* binaryReader;
+
+	/**
+	 * Where to read puzzles as text, or NULL to
+	 * read them in the binary format.
+	 */
+	TextInput* textInput;
+
+	/**
+	 * How to write results in the binary format, or
+	 * NULL to print them as text.
+	 */
+	const BinaryPuzzleWriter* binaryWriter;
+};
+
+/**
+ * What was gathered on the boards used to solve
+ * or generate puzzles, added up.
+ */
+struct BoardTotals {
+	SudokuBoard::Profile profile;
+	unsigned long cacheHits;
+	unsigned long cacheMisses;
+};
+
 long getMicroseconds();
-bool readPuzzleFromStdIn(int* puzzle);
+bool readPuzzle(const PuzzleOptions& options, int* puzzle);
+bool readPuzzleFromText(TextInput* input, int* puzzle);
+int skipPuzzlesInMemory(const char** text, const char* end, int count);
+TextInput* newTextInput();
+TextInput* mapInput(const char* fileName);
+void deleteTextInput(TextInput* input);
+SudokuBoard* newBoard(const PuzzleOptions& options);
+void deleteBoard(SudokuBoard* ss, BoardTotals* totals);
+void solvePuzzle(SudokuBoard* ss, const PuzzleOptions& options, int* solutions);
+bool solveAndPrint(ostream& out, SudokuBoard* ss, const PuzzleOptions& options, int* puzzle);
+void printResults(ostream& out, SudokuBoard* ss, const PuzzleOptions& options, int solutions, long microseconds);
+void printVariants(ostream& out, SudokuBoard* ss, const PuzzleOptions& options, int solutions);
+string getCanonicalPuzzle(SudokuBoard* ss);
+void printMessage(ostream& out, const char* message, SudokuBoard::PrintStyle printStyle);
+void addProfile(SudokuBoard::Profile* total, const SudokuBoard::Profile& profile);
+void printProfile(const SudokuBoard::Profile& profile, SudokuBoard::PrintStyle printStyle);
+#if HAVE_PTHREAD == 1
+	int generateWithThreads(OutputBuffer* output, const PuzzleOptions& options, int numberToGenerate, int threadCount, bool haveSeed, unsigned long seed, BoardTotals* totals);
+	int solveWithThreads(OutputBuffer* output, const PuzzleOptions& options, int threadCount, bool haveSeed, unsigned long seed, BoardTotals* totals);
+#endif
 void printHelp();
 void printVersion();
 void printAbout();
@@ -66,11 +231,24 @@ int main(int argc, char *argv[]){
 		bool countSolutions = false;
 		Action action = NONE;
 		bool logHistory = false;
+		bool profile = false;
 		SudokuBoard::PrintStyle printStyle = SudokuBoard::READABLE;
 		int numberToGenerate = 1;
+		int variants = 0;
+		bool unique = false;
+		int cacheSize = 0;
+		bool binaryInput = false;
+		bool binaryOutput = false;
+		const char* inputFile = NULL;
+		int flushEvery = -1;
 		bool printStats = false;
 		SudokuBoard::Difficulty difficulty = SudokuBoard::UNKNOWN;
 		SudokuBoard::Symmetry symmetry = SudokuBoard::NONE;
+		bool haveSeed = false;
+		unsigned long seed = 0;
+		#if HAVE_PTHREAD == 1
+			int threadCount = 1;
+		#endif
 
 		// Read the arguments and set the options
 		{for (int i=1; i<argc; i++){
@@ -115,6 +293,21 @@ int main(int argc, char *argv[]){
 					}
 					i++;
 				}
+			} else if (!strcmp(argv[i],"--variants")){
+				if (argc <= i+1){
+					cout << "Please specify a number of variants." << endl;
+					return 1;
+				}
+				variants = atoi(argv[i+1]);
+				if (variants < 0 || argv[i+1][0] < '0' || argv[i+1][0] > '9'){
+					cout << "Bad number of variants: " << argv[i+1] << endl;
+					return 1;
+				}
+				i++;
+			} else if (!strcmp(argv[i],"--unique")){
+				unique = true;
+			} else if (!strcmp(argv[i],"--nounique")){
+				unique = false;
 			} else if (!strcmp(argv[i],"--difficulty")){
 				if (argc <= i+1){
 					cout << "Please specify a difficulty." << endl;
@@ -155,6 +348,32 @@ int main(int argc, char *argv[]){
 					return 1;
 				}
 				i++;
+			} else if (!strcmp(argv[i],"--seed")){
+				if (argc <= i+1){
+					cout << "Please specify a seed." << endl;
+					return 1;
+				}
+				char* end;
+				seed = strtoul(argv[i+1], &end, 10);
+				if (argv[i+1][0] < '0' || argv[i+1][0] > '9' || *end != '\0'){
+					cout << "Seed expected to be a number, not " << argv[i+1] << endl;
+					return 1;
+				}
+				haveSeed = true;
+				i++;
+			#if HAVE_PTHREAD == 1
+				} else if (!strcmp(argv[i],"--threads")){
+					if (argc <= i+1){
+						cout << "Please specify a number of threads." << endl;
+						return 1;
+					}
+					threadCount = atoi(argv[i+1]);
+					if (threadCount <= 0){
+						cout << "Bad number of threads: " << argv[i+1] << endl;
+						return 1;
+					}
+					i++;
+			#endif
 			} else if (!strcmp(argv[i],"--solve")){
 				action = SOLVE;
 				printSolution = true;
@@ -162,6 +381,21 @@ int main(int argc, char *argv[]){
 				logHistory = true;
 			} else if (!strcmp(argv[i],"--nolog-history")){
 				logHistory = false;
+			} else if (!strcmp(argv[i],"--profile")){
+				profile = true;
+			} else if (!strcmp(argv[i],"--noprofile")){
+				profile = false;
+			} else if (!strcmp(argv[i],"--cache")){
+				if (argc <= i+1){
+					cout << "Please specify a number of puzzles to cache." << endl;
+					return 1;
+				}
+				cacheSize = atoi(argv[i+1]);
+				if (cacheSize < 0 || argv[i+1][0] < '0' || argv[i+1][0] > '9'){
+					cout << "Bad number of puzzles to cache: " << argv[i+1] << endl;
+					return 1;
+				}
+				i++;
 			} else if (!strcmp(argv[i],"--one-line")){
 				printStyle=SudokuBoard::ONE_LINE;
 			} else if (!strcmp(argv[i],"--compact")){
@@ -170,6 +404,43 @@ int main(int argc, char *argv[]){
 				printStyle=SudokuBoard::READABLE;
 			} else if (!strcmp(argv[i],"--csv")){
 				printStyle=SudokuBoard::CSV;
+			} else if (!strcmp(argv[i],"--in-format") || !strcmp(argv[i],"--out-format")){
+				bool binary = false;
+				if (argc <= i+1){
+					cout << "Please specify a format." << endl;
+					return 1;
+				} else if (!strcmp(argv[i+1],"text")){
+					binary = false;
+				} else if (!strcmp(argv[i+1],"bin")){
+					binary = true;
+				} else {
+					cout << "Format expected to be text or bin, not " << argv[i+1] << endl;
+					return 1;
+				}
+				if (!strcmp(argv[i],"--in-format")){
+					binaryInput = binary;
+				} else {
+					binaryOutput = binary;
+				}
+				i++;
+			} else if (!strcmp(argv[i],"--input")){
+				if (argc <= i+1){
+					cout << "Please specify an input file." << endl;
+					return 1;
+				}
+				inputFile = argv[i+1];
+				i++;
+			} else if (!strcmp(argv[i],"--flush-every")){
+				if (argc <= i+1){
+					cout << "Please specify a number of puzzles." << endl;
+					return 1;
+				}
+				flushEvery = atoi(argv[i+1]);
+				if (flushEvery < 0 || argv[i+1][0] < '0' || argv[i+1][0] > '9'){
+					cout << "Bad number of puzzles: " << argv[i+1] << endl;
+					return 1;
+				}
+				i++;
 			} else if (!strcmp(argv[i],"-n") || !strcmp(argv[i],"--number")){
 				if (i+1 < argc){
 					numberToGenerate = atoi(argv[i+1]);
@@ -200,223 +471,1008 @@ int main(int argc, char *argv[]){
 			return 1;
 		}
 
-		// Initialize the random number generator
-		srand ( unsigned ( time(0) ) );
+		// The binary format has records of puzzles, solutions,
+		// and stats with nothing printed between them
+		if (binaryOutput){
+			if (printHistory || printInstructions || countSolutions || timer || logHistory || profile){
+				cout << "Only puzzles, solutions, and stats can be written in the bin format." << endl;
+				return 1;
+			}
+			printStyle = SudokuBoard::ONE_LINE;
+		}
+
+		// Text from an input file is parsed straight from memory
+		// where possible.  Otherwise, the file is read in place
+		// of standard input.
+		TextInput* textInput = NULL;
+		if (inputFile != NULL && action == SOLVE){
+			if (!binaryInput) textInput = mapInput(inputFile);
+			if (textInput == NULL && freopen(inputFile, "rb", stdin) == NULL){
+				cout << "Could not open input file: " << inputFile << endl;
+				return 1;
+			}
+		}
+		BinaryPuzzleReader* binaryReader = NULL;
+		if (action == SOLVE){
+			if (binaryInput){
+				binaryReader = new BinaryPuzzleReader(cin);
+			} else if (textInput == NULL){
+				textInput = newTextInput();
+			}
+		}
+
+		// Unless asked, write the output for each puzzle
+		// straight away only when someone may be watching.
+		// History logged as it happens is printed straight
+		// away too, so the output for each puzzle must be
+		// written before the next puzzle is solved.
+		if (flushEvery < 0){
+			#if HAVE_UNISTD_H == 1
+				flushEvery = isatty(STDOUT_FILENO) ? 1 : 0;
+			#else
+				flushEvery = 0;
+			#endif
+		}
+		if (logHistory) flushEvery = 1;
+		OutputBuffer outputBuffer(flushEvery);
+		ostream out(&outputBuffer);
+
+		BinaryPuzzleWriter binaryWriter(printSolution, printStats);
+		if (binaryOutput) binaryWriter.writeHeader(out);
 
 		// If printing out CSV, print a header
 		if (printStyle == SudokuBoard::CSV){
-			if (printPuzzle) cout << "Puzzle,";
-			if (printSolution) cout << "Solution,";
-			if (printHistory) cout << "Solve History,";
-			if (printInstructions) cout << "Solve Instructions,";
-			if (countSolutions) cout << "Solution Count,";
-			if (timer) cout << "Time (milliseconds),";
-			if (printStats) cout << "Givens,Singles,Hidden Singles,Naked Pairs,Hidden Pairs,Pointing Pairs/Triples,Box/Line Intersections,Guesses,Backtracks,Difficulty";
-			cout << "" << endl;
+			if (printPuzzle) out << "Puzzle,";
+			if (printSolution) out << "Solution,";
+			if (printHistory) out << "Solve History,";
+			if (printInstructions) out << "Solve Instructions,";
+			if (countSolutions) out << "Solution Count,";
+			if (timer) out << "Time (milliseconds),";
+			if (printStats) out << "Givens,Singles,Hidden Singles,Naked Pairs,Hidden Pairs,Pointing Pairs/Triples,Box/Line Intersections,Guesses,Backtracks,Difficulty";
+			out << "" << endl;
 		}
+		if (flushEvery > 0) outputBuffer.writeBuffer();
+
+		PuzzleOptions options;
+		options.printPuzzle = printPuzzle;
+		options.printSolution = printSolution;
+		options.printHistory = printHistory;
+		options.printInstructions = printInstructions;
+		options.timer = timer;
+		options.countSolutions = countSolutions;
+		options.printStats = printStats;
+		options.logHistory = logHistory;
+		options.profile = profile;
+		options.variants = variants;
+		options.unique = unique;
+		options.cacheSize = cacheSize;
+		options.printStyle = printStyle;
+		options.difficulty = difficulty;
+		options.symmetry = symmetry;
+		options.binaryReader = binaryReader;
+		options.textInput = textInput;
+		options.binaryWriter = binaryOutput ? &binaryWriter : NULL;
+
+		// Use several threads, unless history is logged
+		// as it happens, which only makes sense for one
+		// puzzle at a time.
+		bool threaded = false;
+		BoardTotals totals;
+		memset(&totals, 0, sizeof(totals));
+		#if HAVE_PTHREAD == 1
+			if (threadCount > 1 && !logHistory){
+				if (action == GENERATE){
+					puzzleCount = generateWithThreads(&outputBuffer, options, numberToGenerate, threadCount, haveSeed, seed, &totals);
+				} else {
+					puzzleCount = solveWithThreads(&outputBuffer, options, threadCount, haveSeed, seed, &totals);
+				}
+				threaded = true;
+			}
+		#endif
 
 		// Create a new puzzle board
 		// and set the options
-		SudokuBoard* ss = new SudokuBoard();
-		ss->setRecordHistory(printHistory || printInstructions || printStats || difficulty!=SudokuBoard::UNKNOWN);
-		ss->setLogHistory(logHistory);
-		ss->setPrintStyle(printStyle);
-
-		// Solve puzzle or generate puzzles
-		// until end of input for solving, or
-		// until we have generated the specified number.
-		bool done = false;
-		int numberGenerated = 0;
-		while (!done){
-			// record the start time for the timer.
-			long puzzleStartTime = getMicroseconds();
+		SudokuBoard* ss = newBoard(options);
+		if (haveSeed) ss->setSeed(seed);
+
+		if (action == GENERATE && !threaded){
+			// The canonical forms of the puzzles generated so far
+			set<string> generated;
 
-			// iff something has been printed for this particular puzzle
-			bool printedSomething = false;
+			// Generate puzzles until we have
+			// generated the specified number.
+			int numberGenerated = 0;
+			while (numberGenerated < numberToGenerate){
+				// record the start time for the timer.
+				long puzzleStartTime = getMicroseconds();
 
-			// Record whether the puzzle was possible or not,
-			// so that we don't try to solve impossible givens.
-			bool havePuzzle = false;
-			if (action == GENERATE){
 				// Generate a puzzle
-				havePuzzle = ss->generatePuzzleSymmetry(symmetry);
-				if (!havePuzzle && printPuzzle){
-					cout << "Could not generate puzzle.";
-					if (printStyle==SudokuBoard::CSV){
-						cout << ",";
-					} else {
-						cout << endl;
+				if (!ss->generatePuzzleSymmetry(symmetry)){
+					if (printPuzzle && !binaryOutput){
+						printMessage(out, "Could not generate puzzle.", printStyle);
+						if (printStyle == SudokuBoard::CSV) out << endl;
+						outputBuffer.puzzlesDone(1);
 					}
-					printedSomething = true;
+					continue;
 				}
+
+				int solutions = 0;
+				solvePuzzle(ss, options, &solutions);
+
+				// Bail out if it didn't meet the difficulty standards for generation
+				if (difficulty!=SudokuBoard::UNKNOWN && difficulty!=ss->getDifficulty()) continue;
+
+				// Bail out if the same puzzle, or one that can be
+				// turned into it, has already been generated
+				if (unique && !generated.insert(getCanonicalPuzzle(ss)).second) continue;
+				numberGenerated++;
+
+				// Record the end time for the timer.
+				long puzzleDoneTime = getMicroseconds();
+
+				// With a puzzle now in hand and solved
+				// print out the solution, stats, etc.
+				printResults(out, ss, options, solutions, puzzleDoneTime - puzzleStartTime);
+				if (printStyle == SudokuBoard::CSV) out << endl;
+				puzzleCount++;
+
+				printVariants(out, ss, options, solutions);
+				outputBuffer.puzzlesDone(1);
+			}
+		} else if (action == SOLVE && !threaded){
+			// Solve puzzles until end of input
+			int* puzzle = new int[BOARD_SIZE];
+			long puzzlesRead = 0;
+			while (readPuzzle(options, puzzle)){
+				// Seed each batch the same way as when solving with
+				// threads, so that the output is the same either way
+				if (haveSeed && puzzlesRead%BATCH_SIZE == 0) ss->setSeed(seed + puzzlesRead/BATCH_SIZE);
+				puzzlesRead++;
+				if (solveAndPrint(out, ss, options, puzzle)) puzzleCount++;
+				outputBuffer.puzzlesDone(1);
+			}
+			delete[] puzzle;
+		}
+
+		deleteBoard(ss, &totals);
+		delete binaryReader;
+		if (textInput != NULL) deleteTextInput(textInput);
+		outputBuffer.writeBuffer();
+
+		// Print what was gathered about the solving strategies
+		// while solving or generating all the puzzles.
+		if (profile) printProfile(totals.profile, printStyle);
+
+		long applicationDoneTime = getMicroseconds();
+		// Print out the time it took to do everything
+		if (timer){
+			double t = ((double)(applicationDoneTime - applicationStartTime))/1000000.0;
+			cout << puzzleCount << " puzzle" << ((puzzleCount==1)?"":"s") << " " << (action==GENERATE?"generated":"solved") << " in " << t << " seconds." << endl;
+			if (cacheSize > 0) cout << "Solve cache hits: " << totals.cacheHits << ", misses: " << totals.cacheMisses << endl;
+		}
+
+
+	} catch (char const* s){
+		cout << s <<  endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+OutputBuffer::OutputBuffer(int flush) : buffer(OUTPUT_BUFFER_SIZE) {
+	flushEvery = flush;
+	puzzlesNotWritten = 0;
+	setp(&buffer[0], &buffer[0]+buffer.size());
+}
+
+OutputBuffer::~OutputBuffer(){
+	writeBuffer();
+}
+
+void OutputBuffer::puzzlesDone(int count){
+	puzzlesNotWritten += count;
+	if (flushEvery > 0 && puzzlesNotWritten >= flushEvery) writeBuffer();
+}
+
+/**
+ * Write everything in the buffer to standard output.  It
+ * is written through stdio, so that it stays in order with
+ * anything printed to cout, but in one piece, so that stdio
+ * passes it straight on.
+ */
+void OutputBuffer::writeBuffer(){
+	if (pptr() > pbase()) fwrite(pbase(), 1, pptr()-pbase(), stdout);
+	fflush(stdout);
+	setp(&buffer[0], &buffer[0]+buffer.size());
+	puzzlesNotWritten = 0;
+}
+
+/**
+ * Called when the buffer is full.
+ */
+OutputBuffer::int_type OutputBuffer::overflow(int_type c){
+	writeBuffer();
+	if (c != traits_type::eof()){
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+/**
+ * Flushing writes nothing until the
+ * buffer is written anyway.
+ */
+int OutputBuffer::sync(){
+	return 0;
+}
+
+/**
+ * Create a board for solving or generating
+ * puzzles with the given options.
+ */
+SudokuBoard* newBoard(const PuzzleOptions& options){
+	SudokuBoard* ss = new SudokuBoard();
+	ss->setRecordHistory(options.printHistory || options.printInstructions || options.printStats || options.difficulty!=SudokuBoard::UNKNOWN);
+	ss->setLogHistory(options.logHistory);
+	ss->setProfile(options.profile);
+	ss->setPrintStyle(options.printStyle);
+	// Puzzles found in the cache have no solve history
+	if (options.cacheSize > 0 && !options.printHistory && !options.printInstructions){
+		ss->setSolveCache(new SolveCache(options.cacheSize));
+	}
+	return ss;
+}
+
+/**
+ * Delete a board created by newBoard(), adding what
+ * was gathered on it to the totals.
+ */
+void deleteBoard(SudokuBoard* ss, BoardTotals* totals){
+	addProfile(&totals->profile, ss->getProfile());
+	SolveCache* cache = ss->getSolveCache();
+	if (cache != NULL){
+		totals->cacheHits += cache->getHits();
+		totals->cacheMisses += cache->getMisses();
+		delete cache;
+	}
+	delete ss;
+}
+
+/**
+ * Count the solutions to the puzzle on the board if
+ * requested and solve it if anything printed needs it.
+ */
+void solvePuzzle(SudokuBoard* ss, const PuzzleOptions& options, int* solutions){
+	// Count the solutions if requested.
+	// (Must be done before solving, as it would
+	// mess up the stats.)
+	if (options.countSolutions){
+		*solutions = ss->countSolutions();
+	}
+
+	// Solve the puzzle
+	if (options.printSolution || options.printHistory || options.printStats || options.printInstructions || options.profile || options.difficulty!=SudokuBoard::UNKNOWN){
+		ss->solve();
+	}
+}
+
+/**
+ * Solve a puzzle read from the input and print the results.
+ * Returns false if the givens in the puzzle are not possible.
+ */
+bool solveAndPrint(ostream& out, SudokuBoard* ss, const PuzzleOptions& options, int* puzzle){
+	// record the start time for the timer.
+	long puzzleStartTime = getMicroseconds();
+
+	// Record whether the puzzle was possible or not,
+	// so that we don't try to solve impossible givens.
+	bool havePuzzle = ss->setPuzzle(puzzle);
+
+	// iff something has been printed for this particular puzzle
+	bool printedSomething = false;
+	if (havePuzzle){
+		int solutions = 0;
+		solvePuzzle(ss, options, &solutions);
+
+		// Record the end time for the timer.
+		long puzzleDoneTime = getMicroseconds();
+
+		// With a puzzle now in hand and possibly solved
+		// print out the solution, stats, etc.
+		printResults(out, ss, options, solutions, puzzleDoneTime - puzzleStartTime);
+		printedSomething = true;
+	} else if (options.binaryWriter != NULL){
+		options.binaryWriter->write(out, puzzle, NULL, NULL);
+	} else {
+		if (options.printPuzzle){
+			ss->printPuzzle(out);
+			printedSomething = true;
+		}
+		if (options.printSolution) {
+			printMessage(out, "Puzzle is not possible.", options.printStyle);
+			printedSomething = true;
+		}
+	}
+	if (printedSomething && options.printStyle == SudokuBoard::CSV){
+		out << endl;
+	}
+	return havePuzzle;
+}
+
+/**
+ * Print the puzzle on the board along with its solution,
+ * stats, etc. as requested by the options.
+ */
+void printResults(ostream& out, SudokuBoard* ss, const PuzzleOptions& options, int solutions, long microseconds){
+	SudokuBoard::PrintStyle printStyle = options.printStyle;
+
+	// Write a record with the puzzle and the solution
+	// and stats when they are wanted
+	if (options.binaryWriter != NULL){
+		const int* solution = (options.printSolution && ss->isSolved()) ? ss->getSolution() : NULL;
+		SudokuBoard::Stats stats;
+		if (options.printStats) stats = ss->getStats();
+		options.binaryWriter->write(out, ss->getPuzzle(), solution, options.printStats ? &stats : NULL);
+		return;
+	}
+
+	// Print the puzzle itself.
+	if (options.printPuzzle) ss->printPuzzle(out);
+
+	// Print the solution if there is one
+	if (options.printSolution){
+		if (ss->isSolved()){
+			ss->printSolution(out);
+		} else {
+			printMessage(out, "Puzzle has no solution.", printStyle);
+		}
+	}
+
+	// Print the steps taken to solve or attempt to solve the puzzle.
+	if (options.printHistory) ss->printSolveHistory(out);
+	// Print the instructions for solving the puzzle
+	if (options.printInstructions) ss->printSolveInstructions(out);
+
+	// Print the number of solutions to the puzzle.
+	if (options.countSolutions){
+		if (printStyle == SudokuBoard::CSV){
+			out << solutions << ",";
+		} else {
+			if (solutions == 0){
+				out << "There are no solutions to the puzzle." << endl;
+			} else if (solutions == 1){
+				out << "The solution to the puzzle is unique." << endl;
 			} else {
-				// Read the next puzzle on STDIN
-				int* puzzle = new int[BOARD_SIZE];
-				if (readPuzzleFromStdIn(puzzle)){
-					havePuzzle = ss->setPuzzle(puzzle);
-					if (!havePuzzle){
-						if (printPuzzle){
-							ss->printPuzzle();
-							printedSomething = true;
-						}
-						if (printSolution) {
-							cout << "Puzzle is not possible.";
-							if (printStyle==SudokuBoard::CSV){
-								cout << ",";
-							} else {
-								cout << endl;
-							}
-							printedSomething = true;
-						}
-					}
-				} else {
-					// Set loop to terminate when nothing is left on STDIN
-					havePuzzle = false;
-					done = true;
-				}
-				delete[] puzzle;
+				out << "There are " << solutions << " solutions to the puzzle." << endl;
 			}
+		}
+	}
+
+	// Print out the time it took to solve the puzzle.
+	if (options.timer){
+		double t = ((double)microseconds)/1000.0;
+		if (printStyle == SudokuBoard::CSV){
+			out << t << ",";
+		} else {
+			out << "Time: " << t  << " milliseconds" << endl;
+		}
+	}
 
-			int solutions = 0;
+	// Print any stats we were able to gather while solving the puzzle.
+	if (options.printStats){
+		SudokuBoard::Stats stats = ss->getStats();
+		int givenCount = stats.givenCount;
+		int singleCount = stats.singleCount;
+		int hiddenSingleCount = stats.hiddenSingleCount;
+		int nakedPairCount = stats.nakedPairCount;
+		int hiddenPairCount = stats.hiddenPairCount;
+		int pointingPairTripleCount = stats.pointingPairTripleCount;
+		int boxReductionCount = stats.boxLineReductionCount;
+		int guessCount = stats.guessCount;
+		int backtrackCount = stats.backtrackCount;
+		const char* difficultyString = SudokuBoard::getDifficultyName(stats.difficulty);
+		if (printStyle == SudokuBoard::CSV){
+			out << givenCount << ","  << singleCount << "," << hiddenSingleCount
+					<< "," << nakedPairCount << "," << hiddenPairCount
+					<< ","  << pointingPairTripleCount  << ","  << boxReductionCount
+					<< "," << guessCount << "," << backtrackCount
+					<< "," << difficultyString << ",";
+		} else {
+			out << "Number of Givens: " << givenCount  << endl;
+			out << "Number of Singles: " << singleCount << endl;
+			out << "Number of Hidden Singles: " << hiddenSingleCount  << endl;
+			out << "Number of Naked Pairs: " << nakedPairCount  << endl;
+			out << "Number of Hidden Pairs: " << hiddenPairCount  << endl;
+			out << "Number of Pointing Pairs/Triples: " << pointingPairTripleCount  << endl;
+			out << "Number of Box/Line Intersections: " << boxReductionCount  << endl;
+			out << "Number of Guesses: " << guessCount  << endl;
+			out << "Number of Backtracks: " << backtrackCount  << endl;
+			out << "Difficulty: " << difficultyString  << endl;
+		}
+	}
+}
 
-			if (havePuzzle){
+/**
+ * Print the requested number of random variants of the
+ * puzzle on the board, each of which solves the same way
+ * as the puzzle, so that none of them need to be solved.
+ */
+void printVariants(ostream& out, SudokuBoard* ss, const PuzzleOptions& options, int solutions){
+	{for (int i=0; i<options.variants; i++){
+		long variantStartTime = getMicroseconds();
+		ss->transformRandomly();
+		long variantDoneTime = getMicroseconds();
+		printResults(out, ss, options, solutions, variantDoneTime - variantStartTime);
+		if (options.printStyle == SudokuBoard::CSV) out << endl;
+	}}
+}
 
-				// Count the solutions if requested.
-				// (Must be done before solving, as it would
-				// mess up the stats.)
-				if (countSolutions){
-					solutions = ss->countSolutions();
-				}
+/**
+ * The canonical form of the puzzle on the board, as a string
+ * of 81 digits.  Puzzles that can be turned into each other by
+ * swapping values, rows, columns, and so on have the same one.
+ */
+string getCanonicalPuzzle(SudokuBoard* ss){
+	int canonical[BOARD_SIZE];
+	SudokuBoard::getCanonicalForm(ss->getPuzzle(), canonical);
+	string s(BOARD_SIZE, '0');
+	{for (int i=0; i<BOARD_SIZE; i++){
+		s[i] = (char)('0'+canonical[i]);
+	}}
+	return s;
+}
 
-				// Solve the puzzle
-				if (printSolution || printHistory || printStats || printInstructions || difficulty!=SudokuBoard::UNKNOWN){
-					ss->solve();
-				}
+/**
+ * Print a message in place of a puzzle or solution.
+ */
+void printMessage(ostream& out, const char* message, SudokuBoard::PrintStyle printStyle){
+	out << message;
+	if (printStyle==SudokuBoard::CSV){
+		out << ",";
+	} else {
+		out << endl;
+	}
+}
 
-				// Bail out if it didn't meet the difficulty standards for generation
-				if (action == GENERATE){
-					if (difficulty!=SudokuBoard::UNKNOWN && difficulty!=ss->getDifficulty()){
-						havePuzzle = false;
+/**
+ * Add a profile gathered on one board to the total.
+ */
+void addProfile(SudokuBoard::Profile* total, const SudokuBoard::Profile& profile){
+	{for (int i=0; i<SudokuBoard::STRATEGY_COUNT; i++){
+		total->invocations[i] += profile.invocations[i];
+		total->hits[i] += profile.hits[i];
+		total->ticks[i] += profile.ticks[i];
+	}}
+	total->marks += profile.marks;
+	total->rollbacks += profile.rollbacks;
+}
+
+/**
+ * Print how many times each solving strategy was tried,
+ * how many of those times it made progress, and the
+ * time spent in it.
+ */
+void printProfile(const SudokuBoard::Profile& profile, SudokuBoard::PrintStyle printStyle){
+	string time = string("Time (") + SudokuBoard::getProfileTickUnit() + ")";
+	char line[256];
+	if (printStyle == SudokuBoard::CSV){
+		cout << "Strategy,Invocations,Hits," << time << endl;
+	} else {
+		snprintf(line, sizeof(line), "%-32s %12s %12s %20s", "Strategy", "Invocations", "Hits", time.c_str());
+		cout << line << endl;
+	}
+	{for (int i=0; i<SudokuBoard::STRATEGY_COUNT; i++){
+		const char* name = SudokuBoard::getStrategyName((SudokuBoard::Strategy)i);
+		if (printStyle == SudokuBoard::CSV){
+			cout << name << "," << profile.invocations[i] << "," << profile.hits[i] << "," << profile.ticks[i] << endl;
+		} else {
+			snprintf(line, sizeof(line), "%-32s %12lu %12lu %20llu", name, profile.invocations[i], profile.hits[i], profile.ticks[i]);
+			cout << line << endl;
+		}
+	}}
+	if (printStyle == SudokuBoard::CSV){
+		cout << "Marks," << profile.marks << endl;
+		cout << "Rollbacks," << profile.rollbacks << endl;
+	} else {
+		cout << "Number of Marks: " << profile.marks << endl;
+		cout << "Number of Rollbacks: " << profile.rollbacks << endl;
+	}
+}
+
+#if HAVE_PTHREAD == 1
+
+	/**
+	 * The state shared between the threads that generate
+	 * puzzles and the thread that prints them.
+	 */
+	struct Generation {
+		const PuzzleOptions* options;
+		bool haveSeed;
+		unsigned long seed;
+
+		/**
+		 * Guards everything below.
+		 */
+		pthread_mutex_t lock;
+
+		/**
+		 * Signaled when there is more output, or when
+		 * a thread finishes.
+		 */
+		pthread_cond_t changed;
+
+		/**
+		 * Puzzles are counted when their output is queued,
+		 * so that no more than the requested number are
+		 * ever printed.
+		 */
+		int numberToGenerate;
+		int numberGenerated;
+
+		/**
+		 * Formatted output waiting to be printed.
+		 */
+		vector<string> output;
+
+		int threadsRunning;
+
+		/**
+		 * The first error thrown by any of the threads.
+		 */
+		const char* error;
+
+		/**
+		 * What was gathered on the boards of all the threads.
+		 */
+		BoardTotals* totals;
+
+		/**
+		 * The canonical forms of the puzzles generated so
+		 * far, when only unique puzzles are wanted.
+		 */
+		set<string> generated;
+	};
+
+	/**
+	 * One of the threads generating puzzles.
+	 */
+	struct GenerationThread {
+		Generation* generation;
+		int index;
+		pthread_t thread;
+	};
+
+	/**
+	 * Whether enough puzzles have been generated.
+	 */
+	bool generationDone(Generation* g){
+		pthread_mutex_lock(&g->lock);
+		bool done = (g->numberGenerated >= g->numberToGenerate);
+		pthread_mutex_unlock(&g->lock);
+		return done;
+	}
+
+	/**
+	 * Record a puzzle as generated.  Returns false if the same
+	 * puzzle, or one that can be turned into it, already was.
+	 */
+	bool isNewPuzzle(Generation* g, const string& canonical){
+		pthread_mutex_lock(&g->lock);
+		bool isNew = g->generated.insert(canonical).second;
+		pthread_mutex_unlock(&g->lock);
+		return isNew;
+	}
+
+	/**
+	 * Queue formatted output for printing.  Returns false,
+	 * and queues nothing, if the output is for a puzzle and
+	 * enough puzzles have already been generated.
+	 */
+	bool queueOutput(Generation* g, const string& output, bool isPuzzle){
+		pthread_mutex_lock(&g->lock);
+		bool queued = false;
+		if (g->numberGenerated < g->numberToGenerate){
+			if (isPuzzle) g->numberGenerated++;
+			g->output.push_back(output);
+			pthread_cond_signal(&g->changed);
+			queued = true;
+		}
+		pthread_mutex_unlock(&g->lock);
+		return queued;
+	}
+
+	/**
+	 * Generate puzzles on a board of its own until
+	 * enough have been generated.
+	 */
+	void* generatePuzzles(void* arg){
+		GenerationThread* t = (GenerationThread*)arg;
+		Generation* g = t->generation;
+		const PuzzleOptions& options = *g->options;
+		SudokuBoard* ss = newBoard(options);
+		// Each thread needs its own seed, or they would all
+		// generate the same puzzles
+		if (g->haveSeed) ss->setSeed(g->seed + t->index);
+		try {
+			bool done = false;
+			while (!done){
+				long puzzleStartTime = getMicroseconds();
+				ostringstream out;
+				if (!ss->generatePuzzleSymmetry(options.symmetry)){
+					if (options.printPuzzle && options.binaryWriter == NULL){
+						printMessage(out, "Could not generate puzzle.", options.printStyle);
+						if (options.printStyle == SudokuBoard::CSV) out << endl;
+						done = !queueOutput(g, out.str(), false);
 					} else {
-						numberGenerated++;
-						// Set loop to terminate if enough have been generated.
-						if (numberGenerated >= numberToGenerate) done = true;
+						done = generationDone(g);
 					}
+					continue;
 				}
+				int solutions = 0;
+				solvePuzzle(ss, options, &solutions);
+				if (options.difficulty!=SudokuBoard::UNKNOWN && options.difficulty!=ss->getDifficulty()){
+					// Stop wasting time once the other threads have generated enough
+					done = generationDone(g);
+					continue;
+				}
+				if (options.unique && !isNewPuzzle(g, getCanonicalPuzzle(ss))){
+					done = generationDone(g);
+					continue;
+				}
+				long puzzleDoneTime = getMicroseconds();
+				printResults(out, ss, options, solutions, puzzleDoneTime - puzzleStartTime);
+				if (options.printStyle == SudokuBoard::CSV) out << endl;
+				printVariants(out, ss, options, solutions);
+				done = !queueOutput(g, out.str(), true);
 			}
+		} catch (char const* s){
+			pthread_mutex_lock(&g->lock);
+			if (g->error == NULL) g->error = s;
+			// Stop the other threads
+			g->numberToGenerate = 0;
+			pthread_mutex_unlock(&g->lock);
+		}
+
+		pthread_mutex_lock(&g->lock);
+		deleteBoard(ss, g->totals);
+		g->threadsRunning--;
+		pthread_cond_signal(&g->changed);
+		pthread_mutex_unlock(&g->lock);
+		return NULL;
+	}
 
-			// Check havePuzzle again, it may have changed based on difficulty
-			if (havePuzzle){
+	/**
+	 * A batch of puzzles read from the input
+	 * and solved together by one thread.
+	 */
+	struct PuzzleBatch {
+		enum State {EMPTY, READ, SOLVED};
+		State state;
+		int count;
+		int* puzzles;
 
-				// With a puzzle now in hand and possibly solved
-				// print out the solution, stats, etc.
-				printedSomething = true;
+		/**
+		 * Where the puzzles start in the mapped input file, for
+		 * the thread solving them to parse, or NULL if they
+		 * have already been read.
+		 */
+		const char* text;
 
-				// Record the end time for the timer.
-				long puzzleDoneTime = getMicroseconds();
+		/**
+		 * The number of puzzles in the batch that were possible.
+		 */
+		int possibleCount;
 
-				// Print the puzzle itself.
-				if (printPuzzle) ss->printPuzzle();
+		/**
+		 * The results for the whole batch, formatted for printing.
+		 */
+		string output;
+	};
 
-				// Print the solution if there is one
-				if (printSolution){
-					if (ss->isSolved()){
-						ss->printSolution();
-					} else {
-						cout << "Puzzle has no solution.";
-						if (printStyle==SudokuBoard::CSV){
-							cout << ",";
-						} else {
-							cout << endl;
-						}
-					}
-				}
+	/**
+	 * The state shared between the thread reading puzzles, the
+	 * threads solving them, and the thread printing the results.
+	 * Batches go around a ring: the reader fills them in order,
+	 * the solving threads take them in order, and the results
+	 * are printed in order once each batch is solved, so the
+	 * output is in the same order as the input.  The size of the
+	 * ring limits how far reading and solving can get ahead of
+	 * printing.
+	 */
+	struct BatchSolve {
+		const PuzzleOptions* options;
+		bool haveSeed;
+		unsigned long seed;
 
-				// Print the steps taken to solve or attempt to solve the puzzle.
-				if (printHistory) ss->printSolveHistory();
-				// Print the instructions for solving the puzzle
-				if (printInstructions) ss->printSolveInstructions();
+		/**
+		 * Guards everything below.
+		 */
+		pthread_mutex_t lock;
 
-				// Print the number of solutions to the puzzle.
-				if (countSolutions){
-					if (printStyle == SudokuBoard::CSV){
-						cout << solutions << ",";
-					} else {
-						if (solutions == 0){
-							cout << "There are no solutions to the puzzle." << endl;
-						} else if (solutions == 1){
-							cout << "The solution to the puzzle is unique." << endl;
-						} else {
-							cout << "There are " << solutions << " solutions to the puzzle." << endl;
-						}
+		/**
+		 * Broadcast whenever a batch changes state,
+		 * the input ends, or there is an error.
+		 */
+		pthread_cond_t changed;
+
+		PuzzleBatch* batches;
+		int batchCount;
+
+		/**
+		 * Batches read, taken for solving, and printed so far.
+		 */
+		long batchesRead;
+		long batchesTaken;
+		long batchesPrinted;
+
+		bool endOfInput;
+
+		/**
+		 * The first error thrown by any of the threads.
+		 */
+		const char* error;
+
+		/**
+		 * What was gathered on the boards of all
+		 * the solving threads.
+		 */
+		BoardTotals* totals;
+	};
+
+	/**
+	 * Read batches of puzzles from the input into
+	 * the ring until the input ends.
+	 */
+	void* readPuzzles(void* arg){
+		BatchSolve* b = (BatchSolve*)arg;
+		bool done = false;
+		while (!done){
+			pthread_mutex_lock(&b->lock);
+			PuzzleBatch* batch = &b->batches[b->batchesRead%b->batchCount];
+			while (batch->state != PuzzleBatch::EMPTY && b->error == NULL){
+				pthread_cond_wait(&b->changed, &b->lock);
+			}
+			done = (b->error != NULL);
+			pthread_mutex_unlock(&b->lock);
+			if (done) break;
+
+			// Only this thread touches an empty batch
+			batch->count = 0;
+			batch->text = NULL;
+			const char* error = NULL;
+			TextInput* input = b->options->textInput;
+			if (input != NULL && input->mapped){
+				// Only find where the batch ends, and leave the
+				// parsing to the thread that solves it
+				batch->text = input->next;
+				batch->count = skipPuzzlesInMemory(&input->next, input->end, BATCH_SIZE);
+			} else {
+				try {
+					while (batch->count < BATCH_SIZE && readPuzzle(*b->options, &batch->puzzles[batch->count*BOARD_SIZE])){
+						batch->count++;
 					}
+				} catch (char const* s){
+					error = s;
 				}
+			}
+			done = (batch->count < BATCH_SIZE);
 
-				// Print out the time it took to solve the puzzle.
-				if (timer){
-					double t = ((double)(puzzleDoneTime - puzzleStartTime))/1000.0;
-					if (printStyle == SudokuBoard::CSV){
-						cout << t << ",";
-					} else {
-						cout << "Time: " << t  << " milliseconds" << endl;
-					}
+			pthread_mutex_lock(&b->lock);
+			if (batch->count > 0){
+				batch->state = PuzzleBatch::READ;
+				b->batchesRead++;
+			}
+			b->endOfInput = done;
+			if (error != NULL && b->error == NULL) b->error = error;
+			pthread_cond_broadcast(&b->changed);
+			pthread_mutex_unlock(&b->lock);
+		}
+		return NULL;
+	}
+
+	/**
+	 * Solve batches of puzzles from the ring on a board
+	 * of its own until there are none left to solve.
+	 */
+	void* solvePuzzles(void* arg){
+		BatchSolve* b = (BatchSolve*)arg;
+		const PuzzleOptions& options = *b->options;
+		SudokuBoard* ss = newBoard(options);
+		try {
+			while (true){
+				pthread_mutex_lock(&b->lock);
+				while (b->batchesTaken == b->batchesRead && !b->endOfInput && b->error == NULL){
+					pthread_cond_wait(&b->changed, &b->lock);
+				}
+				if (b->batchesTaken == b->batchesRead || b->error != NULL){
+					pthread_mutex_unlock(&b->lock);
+					break;
 				}
+				long batchNumber = b->batchesTaken++;
+				PuzzleBatch* batch = &b->batches[batchNumber%b->batchCount];
+				pthread_mutex_unlock(&b->lock);
 
-				// Print any stats we were able to gather while solving the puzzle.
-				if (printStats){
-					int givenCount = ss->getGivenCount();
-					int singleCount = ss->getSingleCount();
-					int hiddenSingleCount = ss->getHiddenSingleCount();
-					int nakedPairCount = ss->getNakedPairCount();
-					int hiddenPairCount = ss->getHiddenPairCount();
-					int pointingPairTripleCount = ss->getPointingPairTripleCount();
-					int boxReductionCount = ss->getBoxLineReductionCount();
-					int guessCount = ss->getGuessCount();
-					int backtrackCount = ss->getBacktrackCount();
-					string difficultyString = ss->getDifficultyAsString();
-					if (printStyle == SudokuBoard::CSV){
-						cout << givenCount << ","  << singleCount << "," << hiddenSingleCount
-								<< "," << nakedPairCount << "," << hiddenPairCount
-								<< ","  << pointingPairTripleCount  << ","  << boxReductionCount
-								<< "," << guessCount << "," << backtrackCount
-								<< "," << difficultyString << ",";
-					} else {
-						cout << "Number of Givens: " << givenCount  << endl;
-						cout << "Number of Singles: " << singleCount << endl;
-						cout << "Number of Hidden Singles: " << hiddenSingleCount  << endl;
-						cout << "Number of Naked Pairs: " << nakedPairCount  << endl;
-						cout << "Number of Hidden Pairs: " << hiddenPairCount  << endl;
-						cout << "Number of Pointing Pairs/Triples: " << pointingPairTripleCount  << endl;
-						cout << "Number of Box/Line Intersections: " << boxReductionCount  << endl;
-						cout << "Number of Guesses: " << guessCount  << endl;
-						cout << "Number of Backtracks: " << backtrackCount  << endl;
-						cout << "Difficulty: " << difficultyString  << endl;
-					}
+				// Seed each batch the same way, no matter which
+				// thread solves it, so that runs can be repeated
+				if (b->haveSeed) ss->setSeed(b->seed + batchNumber);
+
+				if (batch->text != NULL){
+					const char* text = batch->text;
+					const char* end = options.textInput->end;
+					{for (int i=0; i<batch->count; i++){
+						text += parsePuzzle(text, end-text, &batch->puzzles[i*BOARD_SIZE]);
+					}}
 				}
-				puzzleCount++;
+
+				ostringstream out;
+				batch->possibleCount = 0;
+				{for (int i=0; i<batch->count; i++){
+					if (solveAndPrint(out, ss, options, &batch->puzzles[i*BOARD_SIZE])) batch->possibleCount++;
+				}}
+				batch->output = out.str();
+
+				pthread_mutex_lock(&b->lock);
+				batch->state = PuzzleBatch::SOLVED;
+				pthread_cond_broadcast(&b->changed);
+				pthread_mutex_unlock(&b->lock);
 			}
-			if (printedSomething && printStyle == SudokuBoard::CSV){
-				cout << endl;
+		} catch (char const* s){
+			pthread_mutex_lock(&b->lock);
+			if (b->error == NULL) b->error = s;
+			pthread_cond_broadcast(&b->changed);
+			pthread_mutex_unlock(&b->lock);
+		}
+		pthread_mutex_lock(&b->lock);
+		deleteBoard(ss, b->totals);
+		pthread_mutex_unlock(&b->lock);
+		return NULL;
+	}
+
+	/**
+	 * Solve the puzzles from standard input on several threads,
+	 * printing the results in the same order as the input.
+	 * Returns the number of puzzles that were possible.
+	 */
+	int solveWithThreads(OutputBuffer* output, const PuzzleOptions& options, int threadCount, bool haveSeed, unsigned long seed, BoardTotals* totals){
+		BatchSolve b;
+		b.options = &options;
+		b.haveSeed = haveSeed;
+		b.seed = seed;
+		pthread_mutex_init(&b.lock, NULL);
+		pthread_cond_init(&b.changed, NULL);
+		b.batchCount = threadCount*4;
+		b.batches = new PuzzleBatch[b.batchCount];
+		{for (int i=0; i<b.batchCount; i++){
+			b.batches[i].state = PuzzleBatch::EMPTY;
+			b.batches[i].count = 0;
+			b.batches[i].puzzles = new int[BATCH_SIZE*BOARD_SIZE];
+			b.batches[i].text = NULL;
+			b.batches[i].possibleCount = 0;
+		}}
+		b.batchesRead = 0;
+		b.batchesTaken = 0;
+		b.batchesPrinted = 0;
+		b.endOfInput = false;
+		b.error = NULL;
+		b.totals = totals;
+
+		pthread_t reader;
+		if (pthread_create(&reader, NULL, readPuzzles, &b) != 0) throw "Could not start any threads.";
+		pthread_t* solvers = new pthread_t[threadCount];
+		int solverCount = 0;
+		{for (int i=0; i<threadCount; i++){
+			if (pthread_create(&solvers[solverCount], NULL, solvePuzzles, &b) == 0) solverCount++;
+		}}
+		if (solverCount == 0){
+			pthread_mutex_lock(&b.lock);
+			b.error = "Could not start any threads.";
+			pthread_cond_broadcast(&b.changed);
+			pthread_mutex_unlock(&b.lock);
+		}
+
+		// Print the results here, in order, so that only
+		// one thread ever writes to the console.
+		int puzzleCount = 0;
+		pthread_mutex_lock(&b.lock);
+		while (b.error == NULL && !(b.endOfInput && b.batchesPrinted == b.batchesRead)){
+			PuzzleBatch* batch = &b.batches[b.batchesPrinted%b.batchCount];
+			if (batch->state != PuzzleBatch::SOLVED){
+				pthread_cond_wait(&b.changed, &b.lock);
+			} else {
+				pthread_mutex_unlock(&b.lock);
+				output->sputn(batch->output.data(), batch->output.size());
+				output->puzzlesDone(batch->count);
+				puzzleCount += batch->possibleCount;
+				batch->output.clear();
+				pthread_mutex_lock(&b.lock);
+				batch->state = PuzzleBatch::EMPTY;
+				b.batchesPrinted++;
+				pthread_cond_broadcast(&b.changed);
 			}
 		}
+		pthread_mutex_unlock(&b.lock);
+
+		pthread_join(reader, NULL);
+		{for (int i=0; i<solverCount; i++){
+			pthread_join(solvers[i], NULL);
+		}}
+		delete[] solvers;
+		{for (int i=0; i<b.batchCount; i++){
+			delete[] b.batches[i].puzzles;
+		}}
+		delete[] b.batches;
+		pthread_cond_destroy(&b.changed);
+		pthread_mutex_destroy(&b.lock);
 
-		delete ss;
+		if (b.error != NULL) throw b.error;
+		return puzzleCount;
+	}
 
-		long applicationDoneTime = getMicroseconds();
-		// Print out the time it took to do everything
-		if (timer){
-			double t = ((double)(applicationDoneTime - applicationStartTime))/1000000.0;
-			cout << puzzleCount << " puzzle" << ((puzzleCount==1)?"":"s") << " " << (action==GENERATE?"generated":"solved") << " in " << t << " seconds." << endl;
+	/**
+	 * Generate puzzles on several threads, printing them as
+	 * they are generated.  Returns the number generated.
+	 */
+	int generateWithThreads(OutputBuffer* output, const PuzzleOptions& options, int numberToGenerate, int threadCount, bool haveSeed, unsigned long seed, BoardTotals* totals){
+		Generation g;
+		g.options = &options;
+		g.haveSeed = haveSeed;
+		g.seed = seed;
+		pthread_mutex_init(&g.lock, NULL);
+		pthread_cond_init(&g.changed, NULL);
+		g.numberToGenerate = numberToGenerate;
+		g.numberGenerated = 0;
+		g.threadsRunning = 0;
+		g.error = NULL;
+		g.totals = totals;
+
+		GenerationThread* threads = new GenerationThread[threadCount];
+		{for (int i=0; i<threadCount; i++){
+			threads[i].generation = &g;
+			threads[i].index = i;
+			pthread_mutex_lock(&g.lock);
+			if (pthread_create(&threads[i].thread, NULL, generatePuzzles, &threads[i]) == 0){
+				g.threadsRunning++;
+			} else {
+				threadCount = i;
+			}
+			pthread_mutex_unlock(&g.lock);
+		}}
+
+		// Print the output from all the threads here, so
+		// that only one thread ever writes to the console.
+		vector<string> queued;
+		pthread_mutex_lock(&g.lock);
+		while (g.threadsRunning > 0 || !g.output.empty()){
+			if (g.output.empty()){
+				pthread_cond_wait(&g.changed, &g.lock);
+			} else {
+				queued.swap(g.output);
+				pthread_mutex_unlock(&g.lock);
+				{for (unsigned int i=0; i<queued.size(); i++){
+					output->sputn(queued[i].data(), queued[i].size());
+					output->puzzlesDone(1);
+				}}
+				queued.clear();
+				pthread_mutex_lock(&g.lock);
+			}
 		}
+		pthread_mutex_unlock(&g.lock);
 
+		{for (int i=0; i<threadCount; i++){
+			pthread_join(threads[i].thread, NULL);
+		}}
+		delete[] threads;
+		pthread_cond_destroy(&g.changed);
+		pthread_mutex_destroy(&g.lock);
 
-	} catch (char const* s){
-		cout << s <<  endl;
-		return 1;
+		if (g.error != NULL) throw g.error;
+		if (threadCount == 0) throw "Could not start any threads.";
+		return g.numberGenerated;
 	}
 
-	return 0;
-}
+#endif
 
 void printVersion(){
 	cout << PACKAGE_STRING << endl;
@@ -451,6 +1507,13 @@ void printHelp(){
 	cout << "  --solve              Solve all the puzzles from standard input" << endl;
 	cout << "  --difficulty <diff>  Generate only simple, easy, intermediate, expert, or any" << endl;
 	cout << "  --symmetry <sym>     Symmetry: none, rotate90, rotate180, mirror, flip, or random" << endl;
+	cout << "  --variants <num>     Also print this many random variants of each generated puzzle" << endl;
+	cout << "  --unique             Generate no two puzzles that can be turned into each other" << endl;
+	cout << "  --nounique           Generate puzzles without checking for repeats (default)" << endl;
+	#if HAVE_PTHREAD == 1
+		cout << "  --threads <num>      Generate or solve puzzles using the given number of threads" << endl;
+	#endif
+	cout << "  --seed <num>         Seed the random numbers so that runs can be repeated" << endl;
 	cout << "  --puzzle             Print the puzzle (default when generating)" << endl;
 	cout << "  --nopuzzle           Do not print the puzzle (default when solving)" << endl;
 	cout << "  --solution           Print the solution (default when solving)" << endl;
@@ -469,37 +1532,140 @@ void printHelp(){
 	cout << "  --noinstructions     Do not print steps to solve (default)" << endl;
 	cout << "  --log-history        Print trial and error to solve as it happens" << endl;
 	cout << "  --nolog-history      Do not print trial and error  to solve as it happens" << endl;
+	cout << "  --cache <num>        Keep the solutions and stats of this many puzzles to reuse" << endl;
+	cout << "  --profile            Print how often each solving strategy was tried and the time taken" << endl;
+	cout << "  --noprofile          Do not print the solving strategy profile (default)" << endl;
 	cout << "  --one-line           Print puzzles on one line of 81 characters" << endl;
 	cout << "  --compact            Print puzzles on 9 lines of 9 characters" << endl;
 	cout << "  --readable           Print puzzles in human readable form (default)" << endl;
 	cout << "  --csv                Output CSV format with one line puzzles" << endl;
+	cout << "  --input <file>       Read the puzzles to solve from a file, not standard input" << endl;
+	cout << "  --in-format <fmt>    Read puzzles as text (default) or bin" << endl;
+	cout << "  --flush-every <num>  Write the output after this many puzzles (default 1 on a terminal)" << endl;
+	cout << "  --out-format <fmt>   Write puzzles as text (default) or bin" << endl;
 	cout << "  --help               Print this message" << endl;
 	cout << "  --about              Author and license information" << endl;
 	cout << "  --version            Display current version number" << endl;
 }
 
 /**
- * Read a sudoku puzzle from standard input.
- * STDIN is processed one character at a time
- * until the sudoku is filled in.  Any digit
- * or period is used to fill the sudoku, any
- * other character is ignored.
+ * Read the next puzzle to solve, in the binary
+ * format or as text.
  */
-bool readPuzzleFromStdIn(int* puzzle){
-	int read = 0;
-	while (read < BOARD_SIZE){
-		char c = getchar();
-		if (c == EOF) return false;
-		if (c >= '1' && c <='9'){
-			puzzle[read] = c-'0';
-			read++;
+bool readPuzzle(const PuzzleOptions& options, int* puzzle){
+	if (options.binaryReader != NULL) return options.binaryReader->read(puzzle, NULL, NULL);
+	return readPuzzleFromText(options.textInput, puzzle);
+}
+
+/**
+ * Read a sudoku puzzle from text.  Any digit or
+ * period is used to fill the sudoku, any other
+ * character is ignored.  Standard input is read a
+ * line at a time until the sudoku is filled in.
+ */
+bool readPuzzleFromText(TextInput* input, int* puzzle){
+	while (true){
+		size_t used = parsePuzzle(input->next, input->end-input->next, puzzle);
+		if (used > 0){
+			input->next += used;
+			return true;
 		}
-		if (c == '.' || c == '0'){
-			puzzle[read] = 0;
+		if (input->mapped) return false;
+
+		// Less than a whole puzzle is left.  Keep only its
+		// squares, as everything else would be ignored, and
+		// read another line after them.
+		int kept = 0;
+		{for (const char* c=input->next; c<input->end; c++){
+			if ((*c >= '0' && *c <= '9') || *c == '.') input->buffer[kept++] = *c;
+		}}
+		input->next = input->buffer;
+		input->end = input->buffer+kept;
+		if (fgets(input->buffer+kept, TEXT_LINE_SIZE, stdin) == NULL) return false;
+		input->end += strlen(input->buffer+kept);
+	}
+}
+
+/**
+ * Move the text in memory past the given number of
+ * puzzles without parsing them.  Returns the number
+ * of whole puzzles passed, which is fewer only if the
+ * text ends first.
+ */
+int skipPuzzlesInMemory(const char** text, const char* end, int count){
+	const char* next = *text;
+	int skipped = 0;
+	int read = 0;
+	while (skipped < count && next < end){
+		char c = *next++;
+		if ((c >= '0' && c <= '9') || c == '.'){
 			read++;
+			if (read == BOARD_SIZE){
+				skipped++;
+				read = 0;
+			}
 		}
 	}
-	return true;
+	*text = next;
+	return skipped;
+}
+
+/**
+ * Read puzzles as text from standard input.
+ */
+TextInput* newTextInput(){
+	TextInput* input = new TextInput();
+	input->next = input->buffer;
+	input->end = input->buffer;
+	input->mapped = false;
+	input->data = NULL;
+	input->size = 0;
+	return input;
+}
+
+/**
+ * Map a file into memory to read puzzles from.  Returns
+ * NULL if it can't be mapped, so that it can be read
+ * some other way.
+ */
+TextInput* mapInput(const char* fileName){
+	#if MAP_INPUT == 1
+		int fd = open(fileName, O_RDONLY);
+		if (fd < 0) return NULL;
+		struct stat st;
+		if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)){
+			close(fd);
+			return NULL;
+		}
+		TextInput* input = newTextInput();
+		input->mapped = true;
+		input->size = (size_t)st.st_size;
+		if (input->size > 0){
+			void* data = mmap(NULL, input->size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED){
+				close(fd);
+				delete input;
+				return NULL;
+			}
+			input->data = (const char*)data;
+			#if HAVE_MADVISE == 1
+				madvise(data, input->size, MADV_SEQUENTIAL);
+			#endif
+		}
+		close(fd);
+		input->next = input->data;
+		input->end = input->data+input->size;
+		return input;
+	#else
+		return NULL;
+	#endif
+}
+
+void deleteTextInput(TextInput* input){
+	#if MAP_INPUT == 1
+		if (input->data != NULL) munmap((void*)input->data, input->size);
+	#endif
+	delete input;
 }
 
 /**
@@ -22,8 +22,24 @@
 #include "config.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 
+#if HAVE_GETTIMEOFDAY == 1
+	#include <sys/time.h>
+#endif
+#include <time.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#include <x86intrin.h>
+	#define QQWING_PROFILE_CYCLES 1
+#endif
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+	#define QQWING_PARSE_SSE2 1
+#endif
+
 #include "qqwing.hpp"
 
 namespace qqwing {
@@ -33,67 +49,202 @@ namespace qqwing {
 	}
 
 	/**
-	 * While solving the puzzle, log steps taken in a log item.
-	 * This is useful for later printing out the solve history
-	 * or gathering statistics about how hard the puzzle was to
-	 * solve.
+	 * A board kept as a bitboard for each value: one 27 bit word for
+	 * each band of three rows, with a bit set for each square in the
+	 * band where the value is still possible.  Filling in a square
+	 * updates a whole band of a value with one mask, and naked singles
+	 * for a band are found by combining the words for all the values
+	 * at once.  The board is small, so the searches that use it copy
+	 * it for each guess rather than taking moves back.
 	 */
-	class LogItem {
+	class Bitboards {
 		public:
-			enum LogType {
-				GIVEN,
-				SINGLE,
-				HIDDEN_SINGLE_ROW,
-				HIDDEN_SINGLE_COLUMN,
-				HIDDEN_SINGLE_SECTION,
-				GUESS,
-				ROLLBACK,
-				NAKED_PAIR_ROW,
-				NAKED_PAIR_COLUMN,
-				NAKED_PAIR_SECTION,
-				POINTING_PAIR_TRIPLE_ROW,
-				POINTING_PAIR_TRIPLE_COLUMN,
-				ROW_BOX,
-				COLUMN_BOX,
-				HIDDEN_PAIR_ROW,
-				HIDDEN_PAIR_COLUMN,
-				HIDDEN_PAIR_SECTION
-			};
-			LogItem(int round, LogType type);
-			LogItem(int round, LogType type, int value, int position);
-			int getRound();
-			void print();
-			LogType getType();
-			~LogItem();
+			Bitboards();
+			bool setPuzzle(const int* puzzle);
+			void getSolution(int* solution);
+			bool propagate();
+			void place(int valIndex, int band, int square);
+
+			/**
+			 * For each value and band, the squares in the
+			 * band where the value is possible.  Squares that
+			 * have been filled in keep the bit for their value.
+			 */
+			unsigned int values[ROW_COL_SEC_SIZE][GRID_SIZE];
+
+			/**
+			 * For each band, the squares not yet filled in.
+			 */
+			unsigned int unsolved[GRID_SIZE];
+		private:
+			bool placeSingles(int band, bool* placed);
+			bool placeHiddenSingles(int valIndex, bool* placed);
+			bool placeHiddenSingle(int valIndex, int band, unsigned int mask, bool* placed);
+	};
+
+	/**
+	 * Counts the solutions to a puzzle without any of the human
+	 * solving strategies or history.  This is an exact cover search
+	 * over the 324 constraints of the puzzle: each square must hold
+	 * one value, and each row, column, and section must hold each
+	 * value once.  Naked and hidden singles, the constraints with
+	 * only one way left to meet them, are filled in on the Bitboards
+	 * until there are none left.  Then the search branches on the
+	 * constraint with the fewest ways left, whether that is a square
+	 * or a value in a row, column, or section.
+	 */
+	class SolutionCounter {
+		public:
+			SolutionCounter();
+			bool setPuzzle(const int* puzzle);
+			void removeGiven(int position);
+			int countSolutions(int limit);
+			bool hasSolutionDifferingAt(const int* solution, const int* positions, int positionCount);
+			bool findSolution(int* grid);
+			bool findRandomSolution(int* grid, unsigned int seed);
+		private:
+			int search(Bitboards& board, int limit);
+			unsigned int nextRandom();
+			int chooseConstraint(const Bitboards& board, int* choices);
+			bool onlyKnownSolutionLeft(const Bitboards& board);
+
+			/**
+			 * The givens, with zero for the empty squares.
+			 */
+			int givens[BOARD_SIZE];
+
+			/**
+			 * While looking for a solution that differs from a
+			 * known one, the squares it must differ in, by value
+			 * from the known solution and band, and by band.
+			 */
+			bool avoiding;
+			unsigned int avoidedValues[ROW_COL_SEC_SIZE][GRID_SIZE];
+			unsigned int avoidedSquares[GRID_SIZE];
+
+			/**
+			 * Where to write the first solution found, or NULL.
+			 */
+			int* found;
+
+			/**
+			 * Whether the ways to meet each constraint are tried
+			 * in a random order, and the seed for the random
+			 * numbers and how many of them have been used.
+			 */
+			bool shuffled;
+			unsigned int randomSeed;
+			unsigned int randomCount;
+	};
+
+	/**
+	 * Finds one solution to a puzzle as quickly as possible, without
+	 * any of the human solving strategies or history, on Bitboards.
+	 * When no more singles can be found, the search guesses,
+	 * preferably at a square with two possibilities, copying the
+	 * board for each guess.
+	 */
+	class BitboardSolver {
+		public:
+			bool setPuzzle(const int* puzzle);
+			bool solve();
+			void getSolution(int* solution);
+		private:
+			bool search();
+			bool chooseGuess(int* band, int* square);
+			Bitboards board;
+	};
+
+	/**
+	 * Finds the canonical form of a puzzle: the smallest, read
+	 * square by square, of all the puzzles it can be turned into
+	 * by swapping values, rows within bands, bands, columns within
+	 * stacks, stacks, or rows with columns.  The values are always
+	 * numbered in the order in which they are first read, so only
+	 * the squares need to be moved around.  The form is built one
+	 * row at a time, keeping every arrangement that gives the
+	 * smallest rows so far and dropping the rest.  Columns in the
+	 * same stack that have had the same values in every row so far
+	 * are kept together in a group, in no particular order, until
+	 * a row tells them apart, so that the many orders of columns
+	 * of unknowns don't each need an arrangement of their own.
+	 * The puzzle must not have conflicting givens: a value seen
+	 * twice in a row would be numbered twice.
+	 */
+	class Canonicalizer {
+		public:
+			void canonicalize(const int* puzzle, int* canonical, int* cellMap, int* valueMap);
 		private:
-			void init(int round, LogType type, int value, int position);
 			/**
-			 * The recursion level at which this item was gathered.
-			 * Used for backing out log items solve branches that
-			 * don't lead to a solution.
+			 * One way of arranging the puzzle that gives the
+			 * smallest rows so far.
 			 */
-			int round;
+			struct Arrangement {
+				/**
+				 * Whether rows are swapped with columns.
+				 */
+				bool transposed;
+
+				/**
+				 * The number of the next value to be read.
+				 */
+				unsigned char nextLabel;
+
+				/**
+				 * The rows (0-8) of the (possibly transposed)
+				 * puzzle used so far, one bit for each.
+				 */
+				unsigned short rowsUsed;
+
+				/**
+				 * Bit i is set when columns i and i+1 of the
+				 * canonical form are in the same group.
+				 */
+				unsigned short grouped;
+
+				/**
+				 * For each row of the canonical form so far,
+				 * the row of the puzzle it comes from.
+				 */
+				unsigned char rows[ROW_COL_SEC_SIZE];
+
+				/**
+				 * For each column of the canonical form, the
+				 * column of the puzzle it comes from.
+				 */
+				unsigned char columns[ROW_COL_SEC_SIZE];
+
+				/**
+				 * The number given to each value of the puzzle,
+				 * zero for values not yet read.
+				 */
+				unsigned char labels[ROW_COL_SEC_SIZE+1];
+			};
+			void nextRow(int row);
+			void fillRow(const Arrangement& a, const int* fromLine, int row, int from, int column);
+			int compareWithBest(int end);
 
 			/**
-			 * The type of log message that will determine the
-			 * message printed.
+			 * The puzzle as given and with rows swapped with columns.
 			 */
-			LogType type;
+			int grids[2][BOARD_SIZE];
 
 			/**
-			 * Value that was set by the operation (or zero for no value)
+			 * The arrangements that give the smallest rows so far,
+			 * and those that give the smallest next row.
 			 */
-			int value;
+			vector<Arrangement> arrangements;
+			vector<Arrangement> nextArrangements;
 
 			/**
-			 * position on the board at which the value (if any) was set.
+			 * The smallest next row so far, if there is one yet,
+			 * and the next row of the arrangement being filled in.
 			 */
-			int position;
+			bool haveBest;
+			int best[ROW_COL_SEC_SIZE];
+			int line[ROW_COL_SEC_SIZE];
 	};
 
-	void shuffleArray(int* array, int size);
-	SudokuBoard::Symmetry getRandomSymmetry();
-	int getLogCount(vector<LogItem*>* v, LogItem::LogType type);
 	static inline int cellToColumn(int cell);
 	static inline int cellToRow(int cell);
 	static inline int cellToSectionStartCell(int cell);
@@ -101,27 +252,103 @@ namespace qqwing {
 	static inline int rowToFirstCell(int row);
 	static inline int columnToFirstCell(int column);
 	static inline int sectionToFirstCell(int section);
-	static inline int getPossibilityIndex(int valueIndex, int cell);
 	static inline int rowColumnToCell(int row, int column);
 	static inline int sectionToCell(int section, int offset);
+	static inline unsigned short valueIndexToBit(int valueIndex);
+	static inline int countBits(unsigned int mask);
+	static inline int lowestBitIndex(unsigned int mask);
+	static inline void addToSet(unsigned int* set, int member);
+	static inline void removeFromSet(unsigned int* set, int member);
+	static inline int nextInSet(const unsigned int* set, int words, int from);
+	static inline void addToCounts(unsigned int* counts, unsigned int mask);
+	static inline unsigned int countsEqual(const unsigned int* counts, int count);
+	static inline unsigned int mixBits(unsigned int x);
+	static LogItem::LogType transposeLogType(LogItem::LogType type);
+
+	/**
+	 * Candidate mask with a bit set for each of the values 1-9.
+	 */
+	const unsigned short ALL_POSSIBILITIES = (1<<ROW_COL_SEC_SIZE)-1;
+
+	/**
+	 * For each square, the set of squares that share a row, column,
+	 * or section with it, including the square itself.
+	 */
+	class PeerSets {
+		public:
+			PeerSets();
+			unsigned int squares[BOARD_SIZE][SQUARE_SET_WORDS];
+	};
+	static const PeerSets peerSets;
+
+	/**
+	 * Masks for the squares of a band of three rows, numbered 0-26
+	 * from the top left of the band.
+	 */
+	const unsigned int BAND_SQUARES = (1u<<SEC_GROUP_SIZE)-1;
+	const unsigned int BAND_ROW = 0x1FF; // shifted by 9 for each row
+	const unsigned int BAND_COLUMN = 0x40201; // shifted by 1 for each column
+	const unsigned int BAND_SECTION = 0x1C0E07; // shifted by 3 for each section
+
+	/**
+	 * Bits needed for counts of up to nine, when counting
+	 * for every bit of a mask at once.
+	 */
+	const int COUNT_BITS = 4;
+
+	/**
+	 * For each square in a band, the squares in the same band that
+	 * share a row, column, or section with it, including the square
+	 * itself.
+	 */
+	class BandPeers {
+		public:
+			BandPeers();
+			unsigned int squares[SEC_GROUP_SIZE];
+	};
+	static const BandPeers bandPeers;
 
 	/**
 	 * Create a new Sudoku board
 	 */
 	SudokuBoard::SudokuBoard() :
-		puzzle ( new int[BOARD_SIZE] ),
-		solution ( new int[BOARD_SIZE] ),
-		solutionRound ( new int[BOARD_SIZE] ),
-		possibilities ( new int[POSSIBILITY_SIZE] ),
-		randomBoardArray ( new int[BOARD_SIZE] ),
-		randomPossibilityArray ( new int[ROW_COL_SEC_SIZE] ),
+		trailSize ( 0 ),
+		solvedCount ( 0 ),
+		emptyCount ( 0 ),
 		recordHistory ( false ),
 		logHistory( false ),
-		solveHistory ( new vector<LogItem*>() ),
-		solveInstructions ( new vector<LogItem*>() ),
+		rollbackCount ( 0 ),
 		printStyle ( READABLE ),
+		profiling ( false ),
+		solveCache ( NULL ),
 		lastSolveRound (0)
 	{
+		clearProfile();
+
+		// Mix in the address of the board so that boards
+		// created at the same time still get different seeds.
+		#if HAVE_GETTIMEOFDAY == 1
+			timeval tv;
+			gettimeofday(&tv, NULL);
+			unsigned long seed = (unsigned long)tv.tv_sec*1000000+tv.tv_usec;
+		#else
+			unsigned long seed = (unsigned long)time(NULL);
+		#endif
+		setSeed(seed ^ (unsigned long)(size_t)this);
+	}
+
+	void SudokuBoard::setSeed(unsigned long seed){
+		// Spread the seed over all four words of state.  Mixing
+		// distinct words gives distinct results, so the state can
+		// never be all zeros.
+		unsigned int x = (unsigned int)seed ^ mixBits((unsigned int)(seed>>16>>16));
+		{for (int i=0; i<4; i++){
+			x += 0x9E3779B9;
+			randomState[i] = mixBits(x);
+		}}
+
+		// The orders in which squares and values are tried are
+		// shuffled in place, so they must start over as well.
 		{for (int i=0; i<BOARD_SIZE; i++){
 			randomBoardArray[i] = i;
 		}}
@@ -130,6 +357,25 @@ namespace qqwing {
 		}}
 	}
 
+	/**
+	 * The next 32 random bits from the random number generator
+	 * for this board (xoshiro128** by David Blackman and
+	 * Sebastiano Vigna).
+	 */
+	inline unsigned int SudokuBoard::nextRandom(){
+		unsigned int* s = randomState;
+		unsigned int x = s[1]*5;
+		unsigned int result = ((x<<7) | (x>>25))*9;
+		unsigned int t = s[1]<<9;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = (s[3]<<11) | (s[3]>>21);
+		return result;
+	}
+
 	/**
 	 * Get the number of cells that are
 	 * set in the puzzle (as opposed to
@@ -173,38 +419,160 @@ namespace qqwing {
 	 * only the givens.
 	 * This method clears any solution, resets statistics,
 	 * and clears any history messages.
+	 *
+	 * Rather than marking the givens one at a time, which
+	 * removes each given's value from all of its peers in
+	 * turn, the possibilities left once all the givens are
+	 * in place are worked out directly from the values used
+	 * in each row, column, and section.  The givens are never
+	 * rolled back, so they are not put on the trail.
 	 */
 	bool SudokuBoard::reset(){
+		// The values used by the givens in each unit
+		unsigned short used[UNIT_COUNT];
+		{for (int i=0; i<UNIT_COUNT; i++){
+			used[i] = 0;
+		}}
+		{for (int position=0; position<BOARD_SIZE; position++){
+			if (puzzle[position] > 0){
+				unsigned short bit = valueIndexToBit(puzzle[position]-1);
+				int row = ROW_UNITS+cellToRow(position);
+				int column = COLUMN_UNITS+cellToColumn(position);
+				int section = SECTION_UNITS+cellToSection(position);
+				// Givens that conflict leave the board part way
+				// through marking them, as they always have.
+				if ((used[row] | used[column] | used[section]) & bit) return resetByMarking();
+				used[row] |= bit;
+				used[column] |= bit;
+				used[section] |= bit;
+			}
+		}}
+
+		trailSize = 0;
+		solvedCount = 0;
+		emptyCount = 0;
+		{for (int i=0; i<UNIT_COUNT*ROW_COL_SEC_SIZE; i++){
+			unitValueCounts[i] = 0;
+		}}
+		{for (int i=0; i<SQUARE_SET_WORDS; i++){
+			nakedSingles[i] = 0;
+		}}
+		{for (int position=0; position<BOARD_SIZE; position++){
+			solution[position] = puzzle[position];
+			if (puzzle[position] > 0){
+				candidates[position] = 0;
+				solvedCount++;
+			} else {
+				int row = ROW_UNITS+cellToRow(position);
+				int column = COLUMN_UNITS+cellToColumn(position);
+				int section = SECTION_UNITS+cellToSection(position);
+				unsigned int possible = ALL_POSSIBILITIES & ~(used[row] | used[column] | used[section]);
+				candidates[position] = (unsigned short)possible;
+				if (possible == 0) emptyCount++;
+				if (countBits(possible) == 1) addToSet(nakedSingles, position);
+				while (possible != 0){
+					int valIndex = lowestBitIndex(possible);
+					unitValueCounts[row*ROW_COL_SEC_SIZE+valIndex]++;
+					unitValueCounts[column*ROW_COL_SEC_SIZE+valIndex]++;
+					unitValueCounts[section*ROW_COL_SEC_SIZE+valIndex]++;
+					possible &= possible-1;
+				}
+			}
+		}}
+		{for (int i=0; i<HIDDEN_SINGLE_WORDS; i++){
+			hiddenSingles[i] = 0;
+		}}
+		{for (int i=0; i<UNIT_COUNT*ROW_COL_SEC_SIZE; i++){
+			if (unitValueCounts[i] == 1) addToSet(hiddenSingles, i);
+		}}
+		resetWorklists();
+		clearHistory();
+
+		if (logHistory || recordHistory){
+			{for (int position=0; position<BOARD_SIZE; position++){
+				if (puzzle[position] > 0) addHistoryItem(LogItem(1, LogItem::GIVEN, puzzle[position], position));
+			}}
+		}
+		return true;
+	}
+
+	/**
+	 * Reset the board by clearing it and then marking
+	 * each of the givens in turn, stopping at the first
+	 * one that is not possible.
+	 */
+	bool SudokuBoard::resetByMarking(){
 		{for (int i=0; i<BOARD_SIZE; i++){
 			solution[i] = 0;
 		}}
 		{for (int i=0; i<BOARD_SIZE; i++){
-			solutionRound[i] = 0;
+			candidates[i] = ALL_POSSIBILITIES;
 		}}
-		{for (int i=0; i<POSSIBILITY_SIZE; i++){
-			possibilities[i] = 0;
+		trailSize = 0;
+		{for (int i=0; i<UNIT_COUNT*ROW_COL_SEC_SIZE; i++){
+			unitValueCounts[i] = ROW_COL_SEC_SIZE;
 		}}
-
-		{for (unsigned int i=0; i<solveHistory->size(); i++){
-			delete solveHistory->at(i);
+		{for (int i=0; i<HIDDEN_SINGLE_WORDS; i++){
+			hiddenSingles[i] = 0;
+		}}
+		{for (int i=0; i<SQUARE_SET_WORDS; i++){
+			nakedSingles[i] = 0;
 		}}
-		solveHistory->clear();
-		solveInstructions->clear();
+		resetWorklists();
+		solvedCount = 0;
+		emptyCount = 0;
+		clearHistory();
 
 		int round = 1;
 		for (int position=0; position<BOARD_SIZE; position++){
 			if (puzzle[position] > 0){
 				int valIndex = puzzle[position]-1;
-				int valPos = getPossibilityIndex(valIndex,position);
 				int value = puzzle[position];
-				if (possibilities[valPos] != 0) return false;
+				if (!isPossible(position, valIndex)) return false;
 				mark(position,round,value);
-				if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::GIVEN, value, position));
+				if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::GIVEN, value, position));
 			}
 		}
 		return true;
 	}
 
+	/**
+	 * Put everything back on the strategy worklists,
+	 * with no changes pending.
+	 */
+	void SudokuBoard::resetWorklists(){
+		{for (int i=0; i<WORKLIST_COUNT*SQUARE_SET_WORDS; i++){
+			worklists[i] = 0;
+		}}
+		{for (int i=0; i<BOARD_SIZE; i++){
+			addToSet(&worklists[NAKED_PAIR_WORK*SQUARE_SET_WORDS], i);
+			addToSet(&worklists[POINTING_ROW_WORK*SQUARE_SET_WORDS], i);
+			addToSet(&worklists[POINTING_COLUMN_WORK*SQUARE_SET_WORDS], i);
+			addToSet(&worklists[ROW_BOX_WORK*SQUARE_SET_WORDS], i);
+			addToSet(&worklists[COLUMN_BOX_WORK*SQUARE_SET_WORDS], i);
+		}}
+		{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
+			addToSet(&worklists[HIDDEN_PAIR_ROW_WORK*SQUARE_SET_WORDS], i);
+			addToSet(&worklists[HIDDEN_PAIR_COLUMN_WORK*SQUARE_SET_WORDS], i);
+			addToSet(&worklists[HIDDEN_PAIR_SECTION_WORK*SQUARE_SET_WORDS], i);
+		}}
+		{for (int i=0; i<BOARD_SIZE; i++){
+			pendingChanges[i] = 0;
+		}}
+		{for (int i=0; i<SQUARE_SET_WORDS; i++){
+			changedSquares[i] = 0;
+		}}
+	}
+
+	void SudokuBoard::clearHistory(){
+		solveHistory.clear();
+		solveInstructions.clear();
+		{for (int i=0; i<LogItem::LOG_TYPE_COUNT; i++){
+			instructionCounts[i] = 0;
+		}}
+		rollbackCount = 0;
+	}
+
 	/**
 	 * Get the difficulty rating.
 	 *
@@ -231,7 +599,13 @@ namespace qqwing {
 	 * setRecordHistory(true), and solve()
 	 */
 	string SudokuBoard::getDifficultyAsString(){
-		SudokuBoard::Difficulty difficulty = getDifficulty();
+		return getDifficultyName(getDifficulty());
+	}
+
+	/**
+	 * The name of a difficulty rating, e.g. "Intermediate"
+	 */
+	const char* SudokuBoard::getDifficultyName(SudokuBoard::Difficulty difficulty){
 		switch (difficulty){
 			case SudokuBoard::EXPERT: return "Expert";
 			case SudokuBoard::INTERMEDIATE: return "Intermediate";
@@ -246,7 +620,7 @@ namespace qqwing {
 	 * because there was only one possible value for that cell.
 	 */
 	int SudokuBoard::getSingleCount(){
-		return getLogCount(solveInstructions, LogItem::SINGLE);
+		return instructionCounts[LogItem::SINGLE];
 	}
 
 	/**
@@ -255,9 +629,9 @@ namespace qqwing {
 	 * the row, column, or section.
 	 */
 	int SudokuBoard::getHiddenSingleCount(){
-		return getLogCount(solveInstructions, LogItem::HIDDEN_SINGLE_ROW) +
-				getLogCount(solveInstructions, LogItem::HIDDEN_SINGLE_COLUMN) +
-				getLogCount(solveInstructions, LogItem::HIDDEN_SINGLE_SECTION);
+		return instructionCounts[LogItem::HIDDEN_SINGLE_ROW] +
+				instructionCounts[LogItem::HIDDEN_SINGLE_COLUMN] +
+				instructionCounts[LogItem::HIDDEN_SINGLE_SECTION];
 	}
 
 	/**
@@ -265,9 +639,9 @@ namespace qqwing {
 	 * in solving this puzzle.
 	 */
 	int SudokuBoard::getNakedPairCount(){
-		return getLogCount(solveInstructions, LogItem::NAKED_PAIR_ROW) +
-				getLogCount(solveInstructions, LogItem::NAKED_PAIR_COLUMN) +
-				getLogCount(solveInstructions, LogItem::NAKED_PAIR_SECTION);
+		return instructionCounts[LogItem::NAKED_PAIR_ROW] +
+				instructionCounts[LogItem::NAKED_PAIR_COLUMN] +
+				instructionCounts[LogItem::NAKED_PAIR_SECTION];
 	}
 
 	/**
@@ -275,9 +649,9 @@ namespace qqwing {
 	 * in solving this puzzle.
 	 */
 	int SudokuBoard::getHiddenPairCount(){
-		return getLogCount(solveInstructions, LogItem::HIDDEN_PAIR_ROW) +
-				getLogCount(solveInstructions, LogItem::HIDDEN_PAIR_COLUMN) +
-				getLogCount(solveInstructions, LogItem::HIDDEN_PAIR_SECTION);
+		return instructionCounts[LogItem::HIDDEN_PAIR_ROW] +
+				instructionCounts[LogItem::HIDDEN_PAIR_COLUMN] +
+				instructionCounts[LogItem::HIDDEN_PAIR_SECTION];
 	}
 
 	/**
@@ -285,8 +659,8 @@ namespace qqwing {
 	 * in solving this puzzle.
 	 */
 	int SudokuBoard::getPointingPairTripleCount(){
-		return getLogCount(solveInstructions, LogItem::POINTING_PAIR_TRIPLE_ROW)+
-			getLogCount(solveInstructions, LogItem::POINTING_PAIR_TRIPLE_COLUMN);
+		return instructionCounts[LogItem::POINTING_PAIR_TRIPLE_ROW]+
+			instructionCounts[LogItem::POINTING_PAIR_TRIPLE_COLUMN];
 	}
 
 	/**
@@ -294,15 +668,15 @@ namespace qqwing {
 	 * in solving this puzzle.
 	 */
 	int SudokuBoard::getBoxLineReductionCount(){
-		return getLogCount(solveInstructions, LogItem::ROW_BOX)+
-			getLogCount(solveInstructions, LogItem::COLUMN_BOX);
+		return instructionCounts[LogItem::ROW_BOX]+
+			instructionCounts[LogItem::COLUMN_BOX];
 	}
 
 	/**
 	 * Get the number lucky guesses in solving this puzzle.
 	 */
 	int SudokuBoard::getGuessCount(){
-		return getLogCount(solveInstructions, LogItem::GUESS);
+		return instructionCounts[LogItem::GUESS];
 	}
 
 	/**
@@ -310,7 +684,26 @@ namespace qqwing {
 	 * when solving this puzzle.
 	 */
 	int SudokuBoard::getBacktrackCount(){
-		return getLogCount(solveHistory, LogItem::ROLLBACK);
+		return rollbackCount;
+	}
+
+	/**
+	 * Get all the statistics about how the puzzle was
+	 * solved at once, along with the difficulty rating.
+	 */
+	SudokuBoard::Stats SudokuBoard::getStats(){
+		Stats stats;
+		stats.givenCount = getGivenCount();
+		stats.singleCount = getSingleCount();
+		stats.hiddenSingleCount = getHiddenSingleCount();
+		stats.nakedPairCount = getNakedPairCount();
+		stats.hiddenPairCount = getHiddenPairCount();
+		stats.pointingPairTripleCount = getPointingPairTripleCount();
+		stats.boxLineReductionCount = getBoxLineReductionCount();
+		stats.guessCount = getGuessCount();
+		stats.backtrackCount = getBacktrackCount();
+		stats.difficulty = getDifficulty();
+		return stats;
 	}
 
 	void SudokuBoard::shuffleRandomArrays(){
@@ -330,6 +723,117 @@ namespace qqwing {
 		return generatePuzzleSymmetry(SudokuBoard::NONE);
 	}
 
+	void SudokuBoard::generateSolutionGrid(int* grid){
+		// The sections on the diagonal don't share any rows or
+		// columns, so each can be any arrangement of the values.
+		int values[ROW_COL_SEC_SIZE];
+		{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
+			values[i] = i+1;
+		}}
+		int base[BOARD_SIZE];
+		{for (int i=0; i<BOARD_SIZE; i++){
+			base[i] = 0;
+		}}
+		{for (int section=0; section<ROW_COL_SEC_SIZE; section+=GRID_SIZE+1){
+			shuffleArray(values, ROW_COL_SEC_SIZE);
+			{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
+				base[sectionToCell(section, i)] = values[i];
+			}}
+		}}
+
+		// Any three such sections can be filled out to a grid.
+		// Fill it out with the search trying values in a random
+		// order, then shuffle the result in all the ways that
+		// keep it a valid grid.
+		SolutionCounter counter;
+		counter.setPuzzle(base);
+		counter.findRandomSolution(base, nextRandom());
+
+		int cellMap[BOARD_SIZE];
+		int valueMap[ROW_COL_SEC_SIZE+1];
+		randomTransformation(cellMap, valueMap);
+		{for (int i=0; i<BOARD_SIZE; i++){
+			grid[i] = valueMap[base[cellMap[i]]];
+		}}
+	}
+
+	/**
+	 * Pick one of the ways of changing a grid that keep it a
+	 * valid grid: swap the values, rows within each band, bands,
+	 * columns within each stack, stacks, and possibly rows with
+	 * columns.  Square i of the changed grid comes from square
+	 * cellMap[i] of the original, and value v becomes valueMap[v].
+	 * valueMap[0] is 0, so that unknowns stay unknown.  Returns
+	 * true if rows are swapped with columns.
+	 */
+	bool SudokuBoard::randomTransformation(int* cellMap, int* valueMap){
+		int rows[ROW_COL_SEC_SIZE];
+		int columns[ROW_COL_SEC_SIZE];
+		int bands[GRID_SIZE];
+		int stacks[GRID_SIZE];
+		{for (int i=0; i<GRID_SIZE; i++){
+			bands[i] = i;
+			stacks[i] = i;
+		}}
+		shuffleArray(bands, GRID_SIZE);
+		shuffleArray(stacks, GRID_SIZE);
+		{for (int i=0; i<GRID_SIZE; i++){
+			int bandRows[GRID_SIZE];
+			int stackColumns[GRID_SIZE];
+			{for (int j=0; j<GRID_SIZE; j++){
+				bandRows[j] = bands[i]*GRID_SIZE+j;
+				stackColumns[j] = stacks[i]*GRID_SIZE+j;
+			}}
+			shuffleArray(bandRows, GRID_SIZE);
+			shuffleArray(stackColumns, GRID_SIZE);
+			{for (int j=0; j<GRID_SIZE; j++){
+				rows[i*GRID_SIZE+j] = bandRows[j];
+				columns[i*GRID_SIZE+j] = stackColumns[j];
+			}}
+		}}
+		valueMap[0] = 0;
+		{for (int i=1; i<=ROW_COL_SEC_SIZE; i++){
+			valueMap[i] = i;
+		}}
+		shuffleArray(valueMap+1, ROW_COL_SEC_SIZE);
+		bool transpose = (nextRandom()&1) != 0;
+		{for (int row=0; row<ROW_COL_SEC_SIZE; row++){
+			{for (int column=0; column<ROW_COL_SEC_SIZE; column++){
+				int from = transpose ? rowColumnToCell(columns[column], rows[row]) : rowColumnToCell(rows[row], columns[column]);
+				cellMap[rowColumnToCell(row, column)] = from;
+			}}
+		}}
+		return transpose;
+	}
+
+	void SudokuBoard::transformRandomly(){
+		int cellMap[BOARD_SIZE];
+		int valueMap[ROW_COL_SEC_SIZE+1];
+		bool transpose = randomTransformation(cellMap, valueMap);
+
+		int oldPuzzle[BOARD_SIZE];
+		int oldSolution[BOARD_SIZE];
+		memcpy(oldPuzzle, puzzle, sizeof(puzzle));
+		memcpy(oldSolution, solution, sizeof(solution));
+		int newPosition[BOARD_SIZE];
+		{for (int i=0; i<BOARD_SIZE; i++){
+			puzzle[i] = valueMap[oldPuzzle[cellMap[i]]];
+			solution[i] = valueMap[oldSolution[cellMap[i]]];
+			newPosition[cellMap[i]] = i;
+		}}
+		{for (unsigned int i=0; i<solveHistory.size(); i++){
+			solveHistory[i].transform(newPosition, valueMap, transpose);
+		}}
+		if (transpose){
+			// Steps in rows are now in columns, and the other way around
+			int oldCounts[LogItem::LOG_TYPE_COUNT];
+			memcpy(oldCounts, instructionCounts, sizeof(instructionCounts));
+			{for (int i=0; i<LogItem::LOG_TYPE_COUNT; i++){
+				instructionCounts[transposeLogType((LogItem::LogType)i)] = oldCounts[i];
+			}}
+		}
+	}
+
 	bool SudokuBoard::generatePuzzleSymmetry(SudokuBoard::Symmetry symmetry){
 
 		if (symmetry == SudokuBoard::RANDOM) symmetry = getRandomSymmetry();
@@ -342,34 +846,25 @@ namespace qqwing {
 
 		clearPuzzle();
 
-		// Start by getting the randomness in order so that
-		// each puzzle will be different from the last.
-		shuffleRandomArrays();
-
-		// Now solve the puzzle the whole way.  The solve
-		// uses random algorithms, so we should have a
-		// really randomly totally filled sudoku
-		// Even when starting from an empty grid
-		solve();
-
-		if (symmetry == SudokuBoard::NONE){
-			// Rollback any square for which it is obvious that
-			// the square doesn't contribute to a unique solution
-			// (ie, squares that were filled by logic rather
-			// than by guess)
-			rollbackNonGuesses();
-		}
-
-		// Record all marked squares as the puzzle so
-		// that we can call countSolutions without losing it.
+		// Start from a random totally filled sudoku.  The
+		// puzzle always has it as its only solution, so taking
+		// out a given leaves more than one solution exactly when
+		// there is a solution that differs from it in one of the
+		// squares taken out.
+		int grid[BOARD_SIZE];
+		generateSolutionGrid(grid);
 		{for (int i=0; i<BOARD_SIZE; i++){
-			puzzle[i] = solution[i];
+			puzzle[i] = grid[i];
 		}}
 
-		// Rerandomize everything so that we test squares
-		// in a different order than they were added.
+		// Randomize the order in which squares are tested.
 		shuffleRandomArrays();
 
+		// The givens left so far, ready for counting solutions.
+		// Each attempt to remove a value starts from a copy.
+		SolutionCounter givens;
+		givens.setPuzzle(puzzle);
+
 		// Remove one value at a time and see if
 		// the puzzle still has only one solution.
 		// If it does, leave it out the point because
@@ -401,30 +896,49 @@ namespace qqwing {
 				}
 				// try backing out the value and
 				// counting solutions to the puzzle
+				SolutionCounter attempt = givens;
+				int removed[4];
+				int removedCount = 0;
 				int savedValue = puzzle[position];
 				puzzle[position] = 0;
+				attempt.removeGiven(position);
+				removed[removedCount++] = position;
 				int savedSym1 = 0;
 				if (positionsym1 >= 0){
 					savedSym1 = puzzle[positionsym1];
 					puzzle[positionsym1] = 0;
+					if (savedSym1 != 0){
+						attempt.removeGiven(positionsym1);
+						removed[removedCount++] = positionsym1;
+					}
 				}
 				int savedSym2 = 0;
 				if (positionsym2 >= 0){
 					savedSym2 = puzzle[positionsym2];
 					puzzle[positionsym2] = 0;
+					if (savedSym2 != 0){
+						attempt.removeGiven(positionsym2);
+						removed[removedCount++] = positionsym2;
+					}
 				}
 				int savedSym3 = 0;
 				if (positionsym3 >= 0){
 					savedSym3 = puzzle[positionsym3];
 					puzzle[positionsym3] = 0;
+					if (savedSym3 != 0){
+						attempt.removeGiven(positionsym3);
+						removed[removedCount++] = positionsym3;
+					}
 				}
-				reset();
-				if (countSolutions(2, true) > 1){
+				if (attempt.hasSolutionDifferingAt(grid, removed, removedCount)){
 					// Put it back in, it is needed
 					puzzle[position] = savedValue;
 					if (positionsym1 >= 0 && savedSym1 != 0) puzzle[positionsym1] = savedSym1;
 					if (positionsym2 >= 0 && savedSym2 != 0) puzzle[positionsym2] = savedSym2;
 					if (positionsym3 >= 0 && savedSym3 != 0) puzzle[positionsym3] = savedSym3;
+				} else {
+					// Leave it out of the givens from now on
+					givens = attempt;
 				}
 			}
 		}}
@@ -440,12 +954,12 @@ namespace qqwing {
 
 	}
 
-	void SudokuBoard::rollbackNonGuesses(){
-		// Guesses are odd rounds
-		// Non-guesses are even rounds
-		{for (int i=2; i<=lastSolveRound; i+=2){
-			rollbackRound(i);
-		}}
+	void SudokuBoard::setSolveCache(SolveCache* cache){
+		solveCache = cache;
+	}
+
+	SolveCache* SudokuBoard::getSolveCache(){
+		return solveCache;
 	}
 
 	void SudokuBoard::setPrintStyle(PrintStyle ps){
@@ -460,62 +974,211 @@ namespace qqwing {
 		logHistory = logHist;
 	}
 
-	void SudokuBoard::addHistoryItem(LogItem* l){
+	void SudokuBoard::setProfile(bool prof){
+		profiling = prof;
+	}
+
+	const SudokuBoard::Profile& SudokuBoard::getProfile(){
+		return profile;
+	}
+
+	void SudokuBoard::clearProfile(){
+		memset(&profile, 0, sizeof(Profile));
+	}
+
+	const char* SudokuBoard::getStrategyName(SudokuBoard::Strategy strategy){
+		switch (strategy){
+			case ONLY_POSSIBILITY_FOR_CELL: return "Single";
+			case ONLY_VALUE_IN_SECTION: return "Hidden Single in Section";
+			case ONLY_VALUE_IN_ROW: return "Hidden Single in Row";
+			case ONLY_VALUE_IN_COLUMN: return "Hidden Single in Column";
+			case NAKED_PAIRS: return "Naked Pair";
+			case POINTING_ROW_REDUCTION: return "Pointing Pair/Triple in Row";
+			case POINTING_COLUMN_REDUCTION: return "Pointing Pair/Triple in Column";
+			case ROW_BOX_REDUCTION: return "Box/Line Intersection in Row";
+			case COLUMN_BOX_REDUCTION: return "Box/Line Intersection in Column";
+			case HIDDEN_PAIR_IN_ROW: return "Hidden Pair in Row";
+			case HIDDEN_PAIR_IN_COLUMN: return "Hidden Pair in Column";
+			case HIDDEN_PAIR_IN_SECTION: return "Hidden Pair in Section";
+			default: return "Unknown";
+		}
+	}
+
+	const char* SudokuBoard::getProfileTickUnit(){
+		#if QQWING_PROFILE_CYCLES == 1
+			return "cycles";
+		#else
+			return "nanoseconds";
+		#endif
+	}
+
+	/**
+	 * Read the clock used to time the strategies while profiling:
+	 * the processor's time stamp counter where there is one, as
+	 * it is much cheaper to read than the system clock.
+	 */
+	static inline unsigned long long readProfileClock(){
+		#if QQWING_PROFILE_CYCLES == 1
+			return __rdtsc();
+		#elif HAVE_CLOCK_GETTIME == 1
+			timespec now;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			return ((unsigned long long)now.tv_sec)*1000000000+now.tv_nsec;
+		#elif HAVE_GETTIMEOFDAY == 1
+			timeval tv;
+			gettimeofday(&tv, NULL);
+			return (((unsigned long long)tv.tv_sec)*1000000+tv.tv_usec)*1000;
+		#else
+			return ((unsigned long long)time(NULL))*1000000000;
+		#endif
+	}
+
+	void SudokuBoard::addHistoryItem(const LogItem& l){
 		if (logHistory){
-			l->print();
+			l.print(cout);
 			cout << endl;
 		}
 		if (recordHistory){
-			solveHistory->push_back(l);
-			solveInstructions->push_back(l);
-		} else {
-			delete l;
+			solveInstructions.push_back(solveHistory.size());
+			solveHistory.push_back(l);
+			instructionCounts[l.getType()]++;
+			if (l.getType() == LogItem::ROLLBACK) rollbackCount++;
 		}
 	}
 
-	void SudokuBoard::printHistory(vector<LogItem*>* v){
+	/**
+	 * Print the whole solve history, or only the
+	 * items in it that are solve instructions.
+	 */
+	void SudokuBoard::printHistory(ostream& out, bool instructionsOnly){
 		if (!recordHistory){
-			cout << "History was not recorded.";
+			out << "History was not recorded.";
 			if (printStyle == CSV){
-				cout << " -- ";
+				out << " -- ";
 			} else {
-				cout << endl;
+				out << endl;
 			}
 		}
-		{for (unsigned int i=0;i<v->size();i++){
-			cout << i+1 << ". ";
-			v->at(i)->print();
+		unsigned int size = instructionsOnly ? solveInstructions.size() : solveHistory.size();
+		{for (unsigned int i=0;i<size;i++){
+			out << i+1 << ". ";
+			solveHistory.at(instructionsOnly ? solveInstructions.at(i) : i).print(out);
 			if (printStyle == CSV){
-				cout << " -- ";
+				out << " -- ";
 			} else {
-				cout << endl;
+				out << endl;
 			}
 		}}
 		if (printStyle == CSV){
-			cout << ",";
+			out << ",";
 		} else {
-			cout << endl;
+			out << endl;
 		}
 	}
 
 	void SudokuBoard::printSolveInstructions(){
+		printSolveInstructions(cout);
+	}
+
+	void SudokuBoard::printSolveInstructions(ostream& out){
 		if (isSolved()){
-			printHistory(solveInstructions);
+			printHistory(out, true);
 		} else {
-			cout << "No solve instructions - Puzzle is not possible to solve." << endl;
+			out << "No solve instructions - Puzzle is not possible to solve." << endl;
 		}
 	}
 
 	void SudokuBoard::printSolveHistory(){
-		printHistory(solveHistory);
+		printSolveHistory(cout);
+	}
+
+	void SudokuBoard::printSolveHistory(ostream& out){
+		printHistory(out, false);
 	}
 
 	bool SudokuBoard::solve(){
+		if (!recordHistory && !logHistory && !profiling) return solveWithBitboards();
+		if (solveCache != NULL && !logHistory && !profiling) return solveWithCache();
+		return solveWithStrategies();
+	}
+
+	/**
+	 * Solve the puzzle with the human solving strategies, unless
+	 * it is in the solve cache, in which case the solution and
+	 * statistics come from there instead.  The cache keeps the
+	 * canonical form of the solution, which is turned back into
+	 * the solution of this puzzle the same way it was found.
+	 * Puzzles with conflicting givens have no canonical form,
+	 * so they are never looked up or added.
+	 */
+	bool SudokuBoard::solveWithCache(){
+		int canonical[BOARD_SIZE];
+		int cellMap[BOARD_SIZE];
+		int valueMap[ROW_COL_SEC_SIZE+1];
+		if (!getCanonicalForm(puzzle, canonical, cellMap, valueMap)) return solveWithStrategies();
+		SolveCache::Entry* entry = solveCache->find(canonical);
+		if (entry != NULL){
+			reset();
+			int values[ROW_COL_SEC_SIZE+1];
+			{for (int value=0; value<=ROW_COL_SEC_SIZE; value++){
+				values[valueMap[value]] = value;
+			}}
+			if (entry->solved){
+				{for (int i=0; i<BOARD_SIZE; i++){
+					solution[cellMap[i]] = values[entry->solution[i]];
+				}}
+				solvedCount = BOARD_SIZE;
+			}
+			{for (int i=0; i<LogItem::LOG_TYPE_COUNT; i++){
+				instructionCounts[i] = entry->instructionCounts[i];
+			}}
+			rollbackCount = entry->rollbackCount;
+			return entry->solved;
+		}
+
+		bool solved = solveWithStrategies();
+		entry = solveCache->add(canonical);
+		entry->solved = solved;
+		{for (int i=0; i<BOARD_SIZE; i++){
+			entry->solution[i] = solved ? valueMap[solution[cellMap[i]]] : 0;
+		}}
+		{for (int i=0; i<LogItem::LOG_TYPE_COUNT; i++){
+			entry->instructionCounts[i] = instructionCounts[i];
+		}}
+		entry->rollbackCount = rollbackCount;
+		return solved;
+	}
+
+	/**
+	 * Solve the puzzle using the human solving strategies,
+	 * guessing in a random order when they run out.
+	 */
+	bool SudokuBoard::solveWithStrategies(){
 		reset();
 		shuffleRandomArrays();
 		return solve(2);
 	}
 
+	/**
+	 * Solve the puzzle without any record of how.  Only the
+	 * solution is filled in; the possibilities used by the solving
+	 * strategies are left as they were when the puzzle was set.
+	 */
+	bool SudokuBoard::solveWithBitboards(){
+		// An earlier solve with the strategies leaves its moves
+		// on the trail, so take them back first.
+		if (trailSize != 0) reset();
+		BitboardSolver solver;
+		if (!solver.setPuzzle(puzzle) || !solver.solve()){
+			reset();
+			return false;
+		}
+		clearHistory();
+		solver.getSolution(solution);
+		solvedCount = BOARD_SIZE;
+		return true;
+	}
+
 	bool SudokuBoard::solve(int round){
 		lastSolveRound = round;
 
@@ -557,90 +1220,898 @@ namespace qqwing {
 		return countSolutions(true);
 	}
 
+	/**
+	 * Count the solutions to the givens in the puzzle, stopping
+	 * at two if limitToTwo is set.  The board itself is not
+	 * changed.
+	 */
 	int SudokuBoard::countSolutions(bool limitToTwo){
-		// Don't record history while generating.
-		bool recHistory = recordHistory;
-		setRecordHistory(false);
-		bool lHistory = logHistory;
-		setLogHistory(false);
-
-		reset();
-		int solutionCount = countSolutions(2, limitToTwo);
-
-		// Restore recording history.
-		setRecordHistory(recHistory);
-		setLogHistory(lHistory);
+		SolutionCounter counter;
+		if (!counter.setPuzzle(puzzle)) return 0;
+		return counter.countSolutions(limitToTwo?2:0);
+	}
 
-		return solutionCount;
+	bool SudokuBoard::getCanonicalForm(const int* puzzle, int* canonical){
+		return getCanonicalForm(puzzle, canonical, NULL, NULL);
 	}
 
-	int SudokuBoard::countSolutions(int round, bool limitToTwo){
-		while (singleSolveMove(round)){
-			if (isSolved()){
-				rollbackRound(round);
-				return 1;
-			}
-			if (isImpossible()){
-				rollbackRound(round);
-				return 0;
-			}
+	bool SudokuBoard::getCanonicalForm(const int* puzzle, int* canonical, int* cellMap, int* valueMap){
+		// The values are numbered as they are read, which only
+		// gives one number per value when no row has a value twice.
+		Bitboards board;
+		if (!board.setPuzzle(puzzle)){
+			{for (int i=0; i<BOARD_SIZE; i++){
+				canonical[i] = 0;
+			}}
+			return false;
 		}
+		Canonicalizer canonicalizer;
+		canonicalizer.canonicalize(puzzle, canonical, cellMap, valueMap);
+		return true;
+	}
 
-		int solutions = 0;
-		int nextRound = round+1;
-		for (int guessNumber=0; guess(nextRound, guessNumber); guessNumber++){
-			solutions += countSolutions(nextRound, limitToTwo);
-			if (limitToTwo && solutions >=2){
-				rollbackRound(round);
-				return solutions;
-			}
-		}
-		rollbackRound(round);
-		return solutions;
+	bool SudokuBoard::hasSolutionDifferingAt(const int* otherSolution, const int* positions, int positionCount){
+		SolutionCounter counter;
+		if (!counter.setPuzzle(puzzle)) return false;
+		// Givens can't differ from the solution
+		int empty[BOARD_SIZE];
+		int emptyCount = 0;
+		{for (int i=0; i<positionCount && emptyCount<BOARD_SIZE; i++){
+			if (puzzle[positions[i]] == 0) empty[emptyCount++] = positions[i];
+		}}
+		return counter.hasSolutionDifferingAt(otherSolution, empty, emptyCount);
 	}
 
-	void SudokuBoard::rollbackRound(int round){
-		if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::ROLLBACK));
-		{for (int i=0; i<BOARD_SIZE; i++){
-			if (solutionRound[i] == round){
-				solutionRound[i] = 0;
-				solution[i] = 0;
-			}
+	Bitboards::Bitboards(){
+		{for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
+			{for (int band=0; band<GRID_SIZE; band++){
+				values[valIndex][band] = BAND_SQUARES;
+			}}
 		}}
-		{for (int i=0; i<POSSIBILITY_SIZE; i++){
-			if (possibilities[i] == round){
-				possibilities[i] = 0;
-			}
+		{for (int band=0; band<GRID_SIZE; band++){
+			unsolved[band] = BAND_SQUARES;
 		}}
-
-		while(solveInstructions->size() > 0 && solveInstructions->back()->getRound() == round){
-			solveInstructions->pop_back();
-		}
 	}
 
-	bool SudokuBoard::isSolved(){
-		{for (int i=0; i<BOARD_SIZE; i++){
-			if (solution[i] == 0){
-				return false;
+	/**
+	 * Fill in the givens from the puzzle.  Returns false if
+	 * two givens conflict, in which case there is no solution.
+	 */
+	bool Bitboards::setPuzzle(const int* puzzle){
+		{for (int position=0; position<BOARD_SIZE; position++){
+			if (puzzle[position] != 0){
+				int valIndex = puzzle[position]-1;
+				int band = position/SEC_GROUP_SIZE;
+				int square = position%SEC_GROUP_SIZE;
+				if ((values[valIndex][band] & (1u<<square)) == 0) return false;
+				place(valIndex, band, square);
 			}
 		}}
 		return true;
 	}
 
-	bool SudokuBoard::isImpossible(){
-		for (int position=0; position<BOARD_SIZE; position++){
-			if (solution[position] == 0){
-				int count = 0;
-				for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-					int valPos = getPossibilityIndex(valIndex,position);
-					if (possibilities[valPos] == 0) count++;
-				}
-				if (count == 0) {
-					return true;
+	/**
+	 * Copy the values from a solved board into an
+	 * array of 81 integers.
+	 */
+	void Bitboards::getSolution(int* solution){
+		{for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
+			{for (int band=0; band<GRID_SIZE; band++){
+				unsigned int squares = values[valIndex][band];
+				while (squares != 0){
+					solution[band*SEC_GROUP_SIZE+lowestBitIndex(squares)] = valIndex+1;
+					squares &= squares-1;
 				}
+			}}
+		}}
+	}
+
+	/**
+	 * Fill in naked and hidden singles until there are none left.
+	 * Returns false if the board is found to have no solution.
+	 */
+	bool Bitboards::propagate(){
+		bool placed = true;
+		while (placed){
+			placed = false;
+			{for (int band=0; band<GRID_SIZE; band++){
+				if (!placeSingles(band, &placed)) return false;
+			}}
+			if (placed) continue;
+			{for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
+				if (!placeHiddenSingles(valIndex, &placed)) return false;
+			}}
+		}
+		return true;
+	}
+
+	/**
+	 * Fill in every square in the band that has only one
+	 * possibility left.  Returns false if a square in the
+	 * band has no possibilities left.
+	 */
+	bool Bitboards::placeSingles(int band, bool* placed){
+		unsigned int unsolvedSquares = unsolved[band];
+		if (unsolvedSquares == 0) return true;
+
+		unsigned int once = 0;
+		unsigned int twice = 0;
+		{for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
+			unsigned int squares = values[valIndex][band];
+			twice |= once & squares;
+			once |= squares;
+		}}
+		if ((unsolvedSquares & ~once) != 0) return false;
+
+		unsigned int singles = unsolvedSquares & ~twice;
+		while (singles != 0){
+			int square = lowestBitIndex(singles);
+			singles &= singles-1;
+			unsigned int bit = 1u<<square;
+			// An earlier single may have taken the last possibility
+			int valIndex = 0;
+			while ((values[valIndex][band] & bit) == 0){
+				valIndex++;
+				if (valIndex == ROW_COL_SEC_SIZE) return false;
 			}
+			place(valIndex, band, square);
+			*placed = true;
 		}
-		return false;
+		return true;
+	}
+
+	/**
+	 * Fill in the value wherever it has only one place left in
+	 * a row, column, or section.  Returns false if it has no
+	 * place left in one of them.
+	 */
+	bool Bitboards::placeHiddenSingles(int valIndex, bool* placed){
+		unsigned int* bands = values[valIndex];
+		{for (int band=0; band<GRID_SIZE; band++){
+			if ((bands[band] & unsolved[band]) == 0) continue;
+			{for (int i=0; i<GRID_SIZE; i++){
+				unsigned int row = BAND_ROW<<(i*ROW_COL_SEC_SIZE);
+				unsigned int section = BAND_SECTION<<(i*GRID_SIZE);
+				if (!placeHiddenSingle(valIndex, band, row, placed)) return false;
+				if (!placeHiddenSingle(valIndex, band, section, placed)) return false;
+			}}
+		}}
+
+		// Fold the nine rows together to find the columns
+		// with no place, or only one place, for the value.
+		unsigned int once = 0;
+		unsigned int twice = 0;
+		unsigned int filled = 0;
+		{for (int band=0; band<GRID_SIZE; band++){
+			unsigned int squares = bands[band];
+			unsigned int placedSquares = squares & ~unsolved[band];
+			{for (int i=0; i<GRID_SIZE; i++){
+				unsigned int row = (squares>>(i*ROW_COL_SEC_SIZE)) & BAND_ROW;
+				twice |= once & row;
+				once |= row;
+				filled |= (placedSquares>>(i*ROW_COL_SEC_SIZE)) & BAND_ROW;
+			}}
+		}}
+		if (once != BAND_ROW) return false;
+		unsigned int columns = once & ~twice & ~filled;
+		while (columns != 0){
+			unsigned int column = BAND_COLUMN<<lowestBitIndex(columns);
+			columns &= columns-1;
+			// Filling in an earlier column may have taken the last place
+			int band = 0;
+			while ((bands[band] & column) == 0){
+				band++;
+				if (band == GRID_SIZE) return false;
+			}
+			place(valIndex, band, lowestBitIndex(bands[band] & column));
+			*placed = true;
+		}
+		return true;
+	}
+
+	/**
+	 * Fill in the value if it has only one place left in the
+	 * row or section of the band given by the mask, unless it
+	 * has already been filled in there.  Returns false if the
+	 * value has no place left in the row or section.
+	 */
+	inline bool Bitboards::placeHiddenSingle(int valIndex, int band, unsigned int mask, bool* placed){
+		unsigned int squares = values[valIndex][band] & mask;
+		if (squares == 0) return false;
+		if ((squares & ~unsolved[band]) != 0) return true;
+		if ((squares & (squares-1)) != 0) return true;
+		place(valIndex, band, lowestBitIndex(squares));
+		*placed = true;
+		return true;
+	}
+
+	/**
+	 * Fill in a square: no other value is possible there, and
+	 * the value is no longer possible anywhere else in the
+	 * row, column, or section.
+	 */
+	inline void Bitboards::place(int valIndex, int band, int square){
+		unsigned int bit = 1u<<square;
+		{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
+			values[i][band] &= ~bit;
+		}}
+		unsigned int* bands = values[valIndex];
+		unsigned int column = BAND_COLUMN<<(square%ROW_COL_SEC_SIZE);
+		{for (int b=0; b<GRID_SIZE; b++){
+			bands[b] &= ~column;
+		}}
+		bands[band] = (bands[band] & ~bandPeers.squares[square]) | bit;
+		unsolved[band] &= ~bit;
+	}
+
+	SolutionCounter::SolutionCounter() :
+		avoiding(false),
+		found(NULL),
+		shuffled(false),
+		randomSeed(0),
+		randomCount(0)
+	{
+		{for (int i=0; i<BOARD_SIZE; i++){
+			givens[i] = 0;
+		}}
+	}
+
+	/**
+	 * Fill in the givens from the puzzle.  Returns false if
+	 * two givens conflict, in which case there are no solutions.
+	 */
+	bool SolutionCounter::setPuzzle(const int* puzzle){
+		{for (int i=0; i<BOARD_SIZE; i++){
+			givens[i] = puzzle[i];
+		}}
+		Bitboards board;
+		return board.setPuzzle(givens);
+	}
+
+	/**
+	 * Take a given back out of the puzzle, leaving its square
+	 * empty.  The counter holds nothing but the givens, so a
+	 * copy of it is a snapshot of them: copy it, remove givens
+	 * from the copy, and count, without setting up the rest of
+	 * the puzzle again.
+	 */
+	void SolutionCounter::removeGiven(int position){
+		givens[position] = 0;
+	}
+
+	/**
+	 * Count the solutions, stopping once limit have been
+	 * found.  A limit of zero counts all the solutions.
+	 */
+	int SolutionCounter::countSolutions(int limit){
+		Bitboards board;
+		if (!board.setPuzzle(givens)) return 0;
+		return search(board, limit);
+	}
+
+	/**
+	 * Whether there is a solution that differs from the given one
+	 * in at least one of the given positions, all of which must be
+	 * empty.  Rather than counting solutions, this looks for just
+	 * one, and gives up on any branch of the search as soon as all
+	 * of the positions have the values from the given solution.
+	 */
+	bool SolutionCounter::hasSolutionDifferingAt(const int* solution, const int* positions, int positionCount){
+		if (positionCount == 0) return false;
+		{for (int band=0; band<GRID_SIZE; band++){
+			avoidedSquares[band] = 0;
+			{for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
+				avoidedValues[valIndex][band] = 0;
+			}}
+		}}
+		{for (int i=0; i<positionCount; i++){
+			int band = positions[i]/SEC_GROUP_SIZE;
+			unsigned int bit = 1u<<(positions[i]%SEC_GROUP_SIZE);
+			avoidedSquares[band] |= bit;
+			avoidedValues[solution[positions[i]]-1][band] |= bit;
+		}}
+		avoiding = true;
+		bool differs = (countSolutions(1) > 0);
+		avoiding = false;
+		return differs;
+	}
+
+	/**
+	 * Fill in the grid with the givens and the first solution
+	 * found.  Returns false, leaving the grid unchanged, if
+	 * there is no solution.
+	 */
+	bool SolutionCounter::findSolution(int* grid){
+		found = grid;
+		bool solved = (countSolutions(1) > 0);
+		found = NULL;
+		return solved;
+	}
+
+	/**
+	 * Fill in the grid with the givens and a solution picked at
+	 * random: wherever the search branches, it tries the ways to
+	 * meet the constraint in a random order made from the seed.
+	 * Returns false, leaving the grid unchanged, if there is no
+	 * solution.
+	 */
+	bool SolutionCounter::findRandomSolution(int* grid, unsigned int seed){
+		shuffled = true;
+		randomSeed = seed;
+		randomCount = 0;
+		bool solved = findSolution(grid);
+		shuffled = false;
+		return solved;
+	}
+
+	inline unsigned int SolutionCounter::nextRandom(){
+		return mixBits(randomSeed + randomCount++);
+	}
+
+	int SolutionCounter::search(Bitboards& board, int limit){
+		if (!board.propagate()) return 0;
+		if (avoiding && onlyKnownSolutionLeft(board)) return 0;
+
+		int choices[ROW_COL_SEC_SIZE];
+		int choiceCount = chooseConstraint(board, choices);
+		if (choiceCount == 0){
+			if (found != NULL) board.getSolution(found);
+			return 1;
+		}
+
+		if (shuffled){
+			{for (int i=0; i<choiceCount; i++){
+				int j = nextRandom()%(choiceCount-i)+i;
+				int temp = choices[i];
+				choices[i] = choices[j];
+				choices[j] = temp;
+			}}
+		}
+
+		int solutions = 0;
+		{for (int i=0; i<choiceCount && (limit == 0 || solutions < limit); i++){
+			int position = choices[i]/ROW_COL_SEC_SIZE;
+			Bitboards guess = board;
+			guess.place(choices[i]%ROW_COL_SEC_SIZE, position/SEC_GROUP_SIZE, position%SEC_GROUP_SIZE);
+			solutions += search(guess, (limit==0)?0:limit-solutions);
+		}}
+		return solutions;
+	}
+
+	/**
+	 * Find the constraint with the fewest ways left to meet it and
+	 * list those ways, each as a position (0-80) times nine plus a
+	 * value index (0-8).  Returns the number of ways, or zero if every
+	 * square is filled in.  There are no singles left on the board,
+	 * so no constraint has fewer than two ways and the first one with
+	 * two is as good as any.  The ways to fill in the squares of a
+	 * band, and to place a value in the columns, are counted for all
+	 * the squares or columns at once, a bit at a time.
+	 */
+	int SolutionCounter::chooseConstraint(const Bitboards& board, int* choices){
+		int best = ROW_COL_SEC_SIZE+1;
+		int bestValIndex = -1;
+		int bestBand = -1;
+		unsigned int bestSquares = 0;
+
+		// The squares
+		{for (int band=0; band<GRID_SIZE && best>2; band++){
+			unsigned int unsolved = board.unsolved[band];
+			if (unsolved == 0) continue;
+			unsigned int counts[COUNT_BITS] = {0, 0, 0, 0};
+			{for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
+				addToCounts(counts, board.values[valIndex][band] & unsolved);
+			}}
+			{for (int count=2; count<best; count++){
+				unsigned int squares = unsolved & countsEqual(counts, count);
+				if (squares != 0){
+					best = count;
+					bestBand = band;
+					bestSquares = squares & (~squares+1);
+				}
+			}}
+		}}
+
+		// Each value in the rows, sections, and columns
+		{for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE && best>2; valIndex++){
+			unsigned int columnCounts[COUNT_BITS] = {0, 0, 0, 0};
+			unsigned int filledColumns = 0;
+			{for (int band=0; band<GRID_SIZE; band++){
+				unsigned int squares = board.values[valIndex][band] & board.unsolved[band];
+				unsigned int filled = board.values[valIndex][band] & ~board.unsolved[band];
+				{for (int i=0; i<GRID_SIZE; i++){
+					unsigned int row = squares & (BAND_ROW<<(i*ROW_COL_SEC_SIZE));
+					unsigned int section = squares & (BAND_SECTION<<(i*GRID_SIZE));
+					if (row != 0 && countBits(row) < best){
+						best = countBits(row);
+						bestValIndex = valIndex;
+						bestBand = band;
+						bestSquares = row;
+					}
+					if (section != 0 && countBits(section) < best){
+						best = countBits(section);
+						bestValIndex = valIndex;
+						bestBand = band;
+						bestSquares = section;
+					}
+					addToCounts(columnCounts, (squares>>(i*ROW_COL_SEC_SIZE)) & BAND_ROW);
+					filledColumns |= (filled>>(i*ROW_COL_SEC_SIZE)) & BAND_ROW;
+				}}
+			}}
+			{for (int count=2; count<best; count++){
+				unsigned int columns = BAND_ROW & ~filledColumns & countsEqual(columnCounts, count);
+				if (columns != 0){
+					best = count;
+					bestValIndex = valIndex;
+					bestBand = -1;
+					bestSquares = BAND_COLUMN<<lowestBitIndex(columns);
+				}
+			}}
+		}}
+
+		int choiceCount = 0;
+		if (best > ROW_COL_SEC_SIZE){
+			// Every square is filled in
+		} else if (bestValIndex == -1){
+			int square = lowestBitIndex(bestSquares);
+			{for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
+				if ((board.values[valIndex][bestBand] & bestSquares) != 0){
+					choices[choiceCount++] = (bestBand*SEC_GROUP_SIZE+square)*ROW_COL_SEC_SIZE+valIndex;
+				}
+			}}
+		} else {
+			{for (int band=0; band<GRID_SIZE; band++){
+				if (bestBand != -1 && band != bestBand) continue;
+				unsigned int squares = bestSquares & board.values[bestValIndex][band] & board.unsolved[band];
+				while (squares != 0){
+					choices[choiceCount++] = (band*SEC_GROUP_SIZE+lowestBitIndex(squares))*ROW_COL_SEC_SIZE+bestValIndex;
+					squares &= squares-1;
+				}
+			}}
+		}
+		return choiceCount;
+	}
+
+	/**
+	 * Whether every square that a solution must differ in has
+	 * been filled in with the value from the known solution.
+	 */
+	bool SolutionCounter::onlyKnownSolutionLeft(const Bitboards& board){
+		{for (int band=0; band<GRID_SIZE; band++){
+			if ((avoidedSquares[band] & board.unsolved[band]) != 0) return false;
+			{for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
+				if ((avoidedValues[valIndex][band] & ~board.values[valIndex][band]) != 0) return false;
+			}}
+		}}
+		return true;
+	}
+
+	/**
+	 * Fill in the givens from the puzzle.  Returns false if
+	 * two givens conflict, in which case there is no solution.
+	 */
+	bool BitboardSolver::setPuzzle(const int* puzzle){
+		return board.setPuzzle(puzzle);
+	}
+
+	/**
+	 * Search for a solution, returning true if one is found.
+	 */
+	bool BitboardSolver::solve(){
+		return search();
+	}
+
+	/**
+	 * Copy the values from a solved board into an
+	 * array of 81 integers.
+	 */
+	void BitboardSolver::getSolution(int* solution){
+		board.getSolution(solution);
+	}
+
+	bool BitboardSolver::search(){
+		if (!board.propagate()) return false;
+
+		int band;
+		int square;
+		if (!chooseGuess(&band, &square)) return true;
+
+		unsigned int bit = 1u<<square;
+		Bitboards saved = board;
+		{for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
+			if ((saved.values[valIndex][band] & bit) != 0){
+				board = saved;
+				board.place(valIndex, band, square);
+				if (search()) return true;
+			}
+		}}
+		return false;
+	}
+
+	/**
+	 * Pick a square to guess at, preferring one with only two
+	 * possibilities.  Returns false if every square is filled in.
+	 */
+	bool BitboardSolver::chooseGuess(int* band, int* square){
+		int firstBand = -1;
+		{for (int b=0; b<GRID_SIZE; b++){
+			unsigned int unsolved = board.unsolved[b];
+			if (unsolved == 0) continue;
+			if (firstBand == -1) firstBand = b;
+			unsigned int once = 0;
+			unsigned int twice = 0;
+			unsigned int thrice = 0;
+			{for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
+				unsigned int squares = board.values[valIndex][b];
+				thrice |= twice & squares;
+				twice |= once & squares;
+				once |= squares;
+			}}
+			unsigned int pairs = unsolved & twice & ~thrice;
+			if (pairs != 0){
+				*band = b;
+				*square = lowestBitIndex(pairs);
+				return true;
+			}
+		}}
+		if (firstBand == -1) return false;
+		*band = firstBand;
+		*square = lowestBitIndex(board.unsolved[firstBand]);
+		return true;
+	}
+
+	/**
+	 * The orders of three things: the stacks,
+	 * or the values in a group of columns.
+	 */
+	static const int ORDERS[6][GRID_SIZE] = {{0,1,2},{0,2,1},{1,0,2},{1,2,0},{2,0,1},{2,1,0}};
+
+	void Canonicalizer::canonicalize(const int* puzzle, int* canonical, int* cellMap, int* valueMap){
+		{for (int i=0; i<BOARD_SIZE; i++){
+			grids[0][i] = puzzle[i];
+			grids[1][i] = puzzle[rowColumnToCell(cellToColumn(i), cellToRow(i))];
+		}}
+
+		// Start with the stacks in each order, and the
+		// columns in each stack in one group.
+		arrangements.clear();
+		Arrangement a;
+		a.nextLabel = 1;
+		a.rowsUsed = 0;
+		a.grouped = 0;
+		{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
+			if (i%GRID_SIZE != GRID_SIZE-1) a.grouped |= 1<<i;
+		}}
+		{for (int i=0; i<=ROW_COL_SEC_SIZE; i++){
+			a.labels[i] = 0;
+		}}
+		{for (int t=0; t<2; t++){
+			a.transposed = (t==1);
+			{for (int o=0; o<6; o++){
+				{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
+					a.columns[i] = ORDERS[o][i/GRID_SIZE]*GRID_SIZE+i%GRID_SIZE;
+				}}
+				arrangements.push_back(a);
+			}}
+		}}
+		{for (int row=0; row<ROW_COL_SEC_SIZE; row++){
+			nextRow(row);
+		}}
+
+		// Every arrangement left gives the same canonical form.
+		Arrangement& first = arrangements[0];
+		{for (int row=0; row<ROW_COL_SEC_SIZE; row++){
+			{for (int column=0; column<ROW_COL_SEC_SIZE; column++){
+				int cell = first.transposed ? rowColumnToCell(first.columns[column], first.rows[row]) : rowColumnToCell(first.rows[row], first.columns[column]);
+				int position = rowColumnToCell(row, column);
+				canonical[position] = first.labels[puzzle[cell]];
+				if (cellMap != NULL) cellMap[position] = cell;
+			}}
+		}}
+		if (valueMap != NULL){
+			// Values that are not in the puzzle at all come last.
+			int nextLabel = first.nextLabel;
+			valueMap[0] = 0;
+			{for (int value=1; value<=ROW_COL_SEC_SIZE; value++){
+				valueMap[value] = (first.labels[value] > 0) ? first.labels[value] : nextLabel++;
+			}}
+		}
+	}
+
+	/**
+	 * Keep the arrangements that can give the smallest next row.
+	 * The first row of each band may come from any band not yet
+	 * used, and the rest of the rows from the same band.
+	 */
+	void Canonicalizer::nextRow(int row){
+		nextArrangements.clear();
+		haveBest = false;
+		{for (unsigned int i=0; i<arrangements.size(); i++){
+			const Arrangement& a = arrangements[i];
+			unsigned int allowed;
+			if (row%GRID_SIZE == 0){
+				allowed = 0;
+				{for (int band=0; band<GRID_SIZE; band++){
+					unsigned int bandRows = 7u<<(band*GRID_SIZE);
+					if ((a.rowsUsed & bandRows) == 0) allowed |= bandRows;
+				}}
+			} else {
+				allowed = (7u<<(a.rows[row-1]/GRID_SIZE*GRID_SIZE)) & ~a.rowsUsed;
+			}
+			{for (; allowed!=0; allowed&=allowed-1){
+				int from = lowestBitIndex(allowed);
+				fillRow(a, grids[a.transposed?1:0]+rowToFirstCell(from), row, from, 0);
+			}}
+		}}
+		arrangements.swap(nextArrangements);
+	}
+
+	/**
+	 * Fill in the next row of the canonical form from the given
+	 * row of the puzzle, one group of columns at a time, starting
+	 * with the group at the given column.  Within a group, the
+	 * unknowns come first, and stay together in a group, then the
+	 * values already numbered, smallest first, then the values that
+	 * have not been read yet.  Those values get the next numbers in
+	 * the order they are put in, so each order of them is tried.
+	 * Rows are abandoned as soon as they are bigger than the
+	 * smallest row so far.
+	 */
+	void Canonicalizer::fillRow(const Arrangement& a, const int* fromLine, int row, int from, int column){
+		if (column == ROW_COL_SEC_SIZE){
+			if (compareWithBest(ROW_COL_SEC_SIZE) < 0){
+				nextArrangements.clear();
+				{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
+					best[i] = line[i];
+				}}
+				haveBest = true;
+			}
+			nextArrangements.push_back(a);
+			Arrangement& next = nextArrangements.back();
+			next.rows[row] = from;
+			next.rowsUsed |= 1<<from;
+			return;
+		}
+
+		int end = column;
+		while (a.grouped & (1<<end)) end++;
+		Arrangement next = a;
+		int place = column;
+		int unread[GRID_SIZE];
+		int unreadCount = 0;
+		// The unknowns
+		{for (int i=column; i<=end; i++){
+			if (fromLine[a.columns[i]] == 0) next.columns[place++] = a.columns[i];
+		}}
+		{for (int i=column; i<end; i++){
+			next.grouped &= ~(1<<i);
+		}}
+		{for (int i=column; i<place; i++){
+			line[i] = 0;
+			if (i+1 < place) next.grouped |= 1<<i;
+		}}
+		// The values already numbered, smallest first
+		int numbered = place;
+		{for (int i=column; i<=end; i++){
+			int value = fromLine[a.columns[i]];
+			if (value == 0) continue;
+			if (a.labels[value] == 0){
+				unread[unreadCount++] = a.columns[i];
+			} else {
+				int j = place++;
+				while (j > numbered && line[j-1] > a.labels[value]){
+					line[j] = line[j-1];
+					next.columns[j] = next.columns[j-1];
+					j--;
+				}
+				line[j] = a.labels[value];
+				next.columns[j] = a.columns[i];
+			}
+		}}
+		if (compareWithBest(place) > 0) return;
+		if (unreadCount == 0){
+			fillRow(next, fromLine, row, from, end+1);
+			return;
+		}
+		// Every order of the values not yet read.  They get
+		// the next numbers in order, so if they are bigger than
+		// the smallest row in the first of them, they always are.
+		line[place] = next.nextLabel;
+		if (compareWithBest(place+1) > 0) return;
+		int orderCount = (unreadCount == 1) ? 1 : ((unreadCount == 2) ? 2 : 6);
+		{for (int o=0; o<6 && orderCount>0; o++){
+			if (unreadCount == 2 && ORDERS[o][2] != 2) continue;
+			orderCount--;
+			Arrangement ordered = next;
+			{for (int i=0; i<unreadCount; i++){
+				int c = unread[ORDERS[o][i]];
+				ordered.columns[place+i] = c;
+				ordered.labels[fromLine[c]] = ordered.nextLabel;
+				line[place+i] = ordered.nextLabel++;
+			}}
+			fillRow(ordered, fromLine, row, from, end+1);
+		}}
+	}
+
+	/**
+	 * Compare the start of the row being filled in, up to the given
+	 * column, with the smallest row so far: negative if it is smaller,
+	 * or if there is no smallest row yet, and positive if it is bigger.
+	 */
+	inline int Canonicalizer::compareWithBest(int end){
+		if (!haveBest) return -1;
+		{for (int i=0; i<end; i++){
+			if (line[i] != best[i]) return line[i]-best[i];
+		}}
+		return 0;
+	}
+
+	SolveCache::SolveCache(int capacity) :
+		entries(capacity > 0 ? capacity : 1),
+		size(0),
+		hand(0),
+		hits(0),
+		misses(0)
+	{
+		int bucketCount = 1;
+		while (bucketCount < 2*(int)entries.size()) bucketCount *= 2;
+		buckets.resize(bucketCount, -1);
+	}
+
+	int SolveCache::getCapacity() const {
+		return (int)entries.size();
+	}
+
+	int SolveCache::getSize() const {
+		return size;
+	}
+
+	/**
+	 * The number of puzzles looked up and found.
+	 */
+	unsigned long SolveCache::getHits() const {
+		return hits;
+	}
+
+	/**
+	 * The number of puzzles looked up and not found.
+	 */
+	unsigned long SolveCache::getMisses() const {
+		return misses;
+	}
+
+	/**
+	 * Drop every puzzle from the cache and start counting
+	 * hits and misses again.
+	 */
+	void SolveCache::clear(){
+		{for (unsigned int i=0; i<buckets.size(); i++){
+			buckets[i] = -1;
+		}}
+		size = 0;
+		hand = 0;
+		hits = 0;
+		misses = 0;
+	}
+
+	inline unsigned int SolveCache::hash(const unsigned char* canonical) const {
+		unsigned int h = 0;
+		{for (int i=0; i<BOARD_SIZE; i++){
+			h = h*31+canonical[i];
+		}}
+		return mixBits(h) & (buckets.size()-1);
+	}
+
+	/**
+	 * Find the entry for a puzzle in canonical form, or NULL
+	 * if it is not in the cache.
+	 */
+	SolveCache::Entry* SolveCache::find(const int* canonical){
+		unsigned char key[BOARD_SIZE];
+		{for (int i=0; i<BOARD_SIZE; i++){
+			key[i] = (unsigned char)canonical[i];
+		}}
+		{for (int index=buckets[hash(key)]; index>=0; index=entries[index].next){
+			Entry& entry = entries[index];
+			if (memcmp(entry.puzzle, key, BOARD_SIZE) == 0){
+				entry.referenced = true;
+				hits++;
+				return &entry;
+			}
+		}}
+		misses++;
+		return NULL;
+	}
+
+	/**
+	 * Add an entry for a puzzle in canonical form that is not in
+	 * the cache, dropping another one if the cache is full.  The
+	 * caller fills in everything but the puzzle.
+	 */
+	SolveCache::Entry* SolveCache::add(const int* canonical){
+		int index;
+		if (size < (int)entries.size()){
+			index = size++;
+		} else {
+			// Give each entry found since the hand last
+			// passed it another trip around
+			while (entries[hand].referenced){
+				entries[hand].referenced = false;
+				hand = (hand+1)%entries.size();
+			}
+			index = hand;
+			hand = (hand+1)%entries.size();
+			unlink(index);
+		}
+		Entry& entry = entries[index];
+		{for (int i=0; i<BOARD_SIZE; i++){
+			entry.puzzle[i] = (unsigned char)canonical[i];
+		}}
+		entry.referenced = false;
+		unsigned int bucket = hash(entry.puzzle);
+		entry.next = buckets[bucket];
+		buckets[bucket] = index;
+		return &entry;
+	}
+
+	/**
+	 * Take an entry out of its hash bucket.
+	 */
+	void SolveCache::unlink(int index){
+		int* link = &buckets[hash(entries[index].puzzle)];
+		while (*link != index) link = &entries[*link].next;
+		*link = entries[index].next;
+	}
+
+	/**
+	 * Undo everything done in the given round.  Rounds are
+	 * rolled back in the reverse order in which they were
+	 * started, so the changes for the round are always the
+	 * ones on the top of the trail.
+	 */
+	void SudokuBoard::rollbackRound(int round){
+		if (profiling) profile.rollbacks++;
+		if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::ROLLBACK));
+		while (trailSize > 0 && trail[trailSize-1].round == (unsigned char)round){
+			trailSize--;
+			undoTrailEntry(trail[trailSize]);
+		}
+
+		while(solveInstructions.size() > 0 && solveHistory.at(solveInstructions.back()).getRound() == round){
+			instructionCounts[solveHistory.at(solveInstructions.back()).getType()]--;
+			solveInstructions.pop_back();
+		}
+	}
+
+	/**
+	 * Restore the possibilities removed by a trail entry
+	 * and clear the value it placed, if any.  Squares that
+	 * have been filled in lose no more possibilities, so a
+	 * square is still filled in only when undoing the entry
+	 * that filled it in.
+	 */
+	inline void SudokuBoard::undoTrailEntry(const TrailEntry& entry){
+		if (solution[entry.position] != 0){
+			solution[entry.position] = 0;
+			solvedCount--;
+		} else if (candidates[entry.position] == 0){
+			emptyCount--;
+		}
+		candidates[entry.position] |= entry.removed;
+		possibilitiesChanged(entry.position, entry.removed);
+		unsigned int restored = entry.removed;
+		while (restored != 0){
+			restoreToUnitCounts(entry.position, lowestBitIndex(restored));
+			restored &= restored-1;
+		}
+	}
+
+	bool SudokuBoard::isSolved(){
+		return solvedCount == BOARD_SIZE;
+	}
+
+	bool SudokuBoard::isImpossible(){
+		return emptyCount > 0;
 	}
 
 	int SudokuBoard::findPositionWithFewestPossibilities(){
@@ -649,11 +2120,7 @@ namespace qqwing {
 		{for (int i=0; i<BOARD_SIZE; i++){
 			int position = randomBoardArray[i];
 			if (solution[position] == 0){
-				int count = 0;
-				for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-					int valPos = getPossibilityIndex(valIndex,position);
-					if (possibilities[valPos] == 0) count++;
-				}
+				int count = countPossibilities(position);
 				if (count < minPossibilities){
 					minPossibilities = count;
 					bestPosition = position;
@@ -668,11 +2135,10 @@ namespace qqwing {
 		int position = findPositionWithFewestPossibilities();
 		{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
 			int valIndex = randomPossibilityArray[i];
-			int valPos = getPossibilityIndex(valIndex,position);
-			if (possibilities[valPos] == 0){
+			if (isPossible(position, valIndex)){
 				if (localGuessCount == guessNumber){
 					int value = valIndex+1;
-					if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::GUESS, value, position));
+					if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::GUESS, value, position));
 					mark(position, round, value);
 					return true;
 				}
@@ -683,10 +2149,12 @@ namespace qqwing {
 	}
 
 	bool SudokuBoard::singleSolveMove(int round){
+		if (profiling) return profiledSingleSolveMove(round);
 		if (onlyPossibilityForCell(round)) return true;
 		if (onlyValueInSection(round)) return true;
 		if (onlyValueInRow(round)) return true;
 		if (onlyValueInColumn(round)) return true;
+		updateWorklists();
 		if (handleNakedPairs(round)) return true;
 		if (pointingRowReduction(round)) return true;
 		if (pointingColumnReduction(round)) return true;
@@ -698,233 +2166,247 @@ namespace qqwing {
 		return false;
 	}
 
+	/**
+	 * The same as singleSolveMove(), but counting
+	 * and timing each strategy as it is tried.
+	 */
+	bool SudokuBoard::profiledSingleSolveMove(int round){
+		{for (int strategy=0; strategy<STRATEGY_COUNT; strategy++){
+			if (strategy == NAKED_PAIRS) updateWorklists();
+			unsigned long long start = readProfileClock();
+			bool hit = applyStrategy(strategy, round);
+			profile.ticks[strategy] += readProfileClock() - start;
+			profile.invocations[strategy]++;
+			if (hit){
+				profile.hits[strategy]++;
+				return true;
+			}
+		}}
+		return false;
+	}
+
+	inline bool SudokuBoard::applyStrategy(int strategy, int round){
+		switch (strategy){
+			case ONLY_POSSIBILITY_FOR_CELL: return onlyPossibilityForCell(round);
+			case ONLY_VALUE_IN_SECTION: return onlyValueInSection(round);
+			case ONLY_VALUE_IN_ROW: return onlyValueInRow(round);
+			case ONLY_VALUE_IN_COLUMN: return onlyValueInColumn(round);
+			case NAKED_PAIRS: return handleNakedPairs(round);
+			case POINTING_ROW_REDUCTION: return pointingRowReduction(round);
+			case POINTING_COLUMN_REDUCTION: return pointingColumnReduction(round);
+			case ROW_BOX_REDUCTION: return rowBoxReduction(round);
+			case COLUMN_BOX_REDUCTION: return colBoxReduction(round);
+			case HIDDEN_PAIR_IN_ROW: return hiddenPairInRow(round);
+			case HIDDEN_PAIR_IN_COLUMN: return hiddenPairInColumn(round);
+			case HIDDEN_PAIR_IN_SECTION: return hiddenPairInSection(round);
+			default: return false;
+		}
+	}
+
 	bool SudokuBoard::colBoxReduction(int round){
-		for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-			for (int col=0; col<ROW_COL_SEC_SIZE; col++){
-				int colStart = columnToFirstCell(col);
-				bool inOneBox = true;
-				int colBox = -1;
+		for (int item=nextUnchecked(COLUMN_BOX_WORK, 0); item!=-1; item=nextUnchecked(COLUMN_BOX_WORK, item+1)){
+			int valIndex = item/ROW_COL_SEC_SIZE;
+			int col = item%ROW_COL_SEC_SIZE;
+			int colStart = columnToFirstCell(col);
+			bool inOneBox = true;
+			int colBox = -1;
+			{for (int i=0; i<GRID_SIZE; i++){
+				for (int j=0; j<GRID_SIZE; j++){
+					int row = i*GRID_SIZE+j;
+					int position = rowColumnToCell(row, col);
+					if (isPossible(position, valIndex)){
+						if (colBox == -1 || colBox == i){
+							colBox = i;
+						} else {
+							inOneBox = false;
+						}
+					}
+
+				}
+			}}
+			if (inOneBox && colBox != -1){
+				bool doneSomething = false;
+				int row = GRID_SIZE*colBox;
+				int secStart = cellToSectionStartCell(rowColumnToCell(row, col));
+				int secStartRow = cellToRow(secStart);
+				int secStartCol = cellToColumn(secStart);
 				{for (int i=0; i<GRID_SIZE; i++){
 					for (int j=0; j<GRID_SIZE; j++){
-						int row = i*GRID_SIZE+j;
-						int position = rowColumnToCell(row, col);
-						int valPos = getPossibilityIndex(valIndex,position);
-						if(possibilities[valPos] == 0){
-							if (colBox == -1 || colBox == i){
-								colBox = i;
-							} else {
-								inOneBox = false;
-							}
+						int row2 = secStartRow+i;
+						int col2 = secStartCol+j;
+						int position = rowColumnToCell(row2, col2);
+						if (col != col2 && eliminatePossibility(position, valIndex, round)){
+							doneSomething = true;
 						}
-
 					}
 				}}
-				if (inOneBox && colBox != -1){
-					bool doneSomething = false;
-					int row = GRID_SIZE*colBox;
-					int secStart = cellToSectionStartCell(rowColumnToCell(row, col));
-					int secStartRow = cellToRow(secStart);
-					int secStartCol = cellToColumn(secStart);
-					{for (int i=0; i<GRID_SIZE; i++){
-						for (int j=0; j<GRID_SIZE; j++){
-							int row2 = secStartRow+i;
-							int col2 = secStartCol+j;
-							int position = rowColumnToCell(row2, col2);
-							int valPos = getPossibilityIndex(valIndex,position);
-							if (col != col2 && possibilities[valPos] == 0){
-								possibilities[valPos] = round;
-								doneSomething = true;
-							}
-						}
-					}}
-					if (doneSomething){
-						if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::COLUMN_BOX, valIndex+1, colStart));
-						return true;
-					}
+				if (doneSomething){
+					if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::COLUMN_BOX, valIndex+1, colStart));
+					return true;
 				}
 			}
+			checked(COLUMN_BOX_WORK, item);
 		}
 		return false;
 	}
 
 	bool SudokuBoard::rowBoxReduction(int round){
-		for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-			for (int row=0; row<ROW_COL_SEC_SIZE; row++){
-				int rowStart = rowToFirstCell(row);
-				bool inOneBox = true;
-				int rowBox = -1;
+		for (int item=nextUnchecked(ROW_BOX_WORK, 0); item!=-1; item=nextUnchecked(ROW_BOX_WORK, item+1)){
+			int valIndex = item/ROW_COL_SEC_SIZE;
+			int row = item%ROW_COL_SEC_SIZE;
+			int rowStart = rowToFirstCell(row);
+			bool inOneBox = true;
+			int rowBox = -1;
+			{for (int i=0; i<GRID_SIZE; i++){
+				for (int j=0; j<GRID_SIZE; j++){
+					int column = i*GRID_SIZE+j;
+					int position = rowColumnToCell(row, column);
+					if (isPossible(position, valIndex)){
+						if (rowBox == -1 || rowBox == i){
+							rowBox = i;
+						} else {
+							inOneBox = false;
+						}
+					}
+
+				}
+			}}
+			if (inOneBox && rowBox != -1){
+				bool doneSomething = false;
+				int column = GRID_SIZE*rowBox;
+				int secStart = cellToSectionStartCell(rowColumnToCell(row, column));
+				int secStartRow = cellToRow(secStart);
+				int secStartCol = cellToColumn(secStart);
 				{for (int i=0; i<GRID_SIZE; i++){
 					for (int j=0; j<GRID_SIZE; j++){
-						int column = i*GRID_SIZE+j;
-						int position = rowColumnToCell(row, column);
-						int valPos = getPossibilityIndex(valIndex,position);
-						if(possibilities[valPos] == 0){
-							if (rowBox == -1 || rowBox == i){
-								rowBox = i;
-							} else {
-								inOneBox = false;
-							}
+						int row2 = secStartRow+i;
+						int col2 = secStartCol+j;
+						int position = rowColumnToCell(row2, col2);
+						if (row != row2 && eliminatePossibility(position, valIndex, round)){
+							doneSomething = true;
 						}
-
 					}
 				}}
-				if (inOneBox && rowBox != -1){
-					bool doneSomething = false;
-					int column = GRID_SIZE*rowBox;
-					int secStart = cellToSectionStartCell(rowColumnToCell(row, column));
-					int secStartRow = cellToRow(secStart);
-					int secStartCol = cellToColumn(secStart);
-					{for (int i=0; i<GRID_SIZE; i++){
-						for (int j=0; j<GRID_SIZE; j++){
-							int row2 = secStartRow+i;
-							int col2 = secStartCol+j;
-							int position = rowColumnToCell(row2, col2);
-							int valPos = getPossibilityIndex(valIndex,position);
-							if (row != row2 && possibilities[valPos] == 0){
-								possibilities[valPos] = round;
-								doneSomething = true;
-							}
+				if (doneSomething){
+					if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::ROW_BOX, valIndex+1, rowStart));
+					return true;
+				}
+			}
+			checked(ROW_BOX_WORK, item);
+		}
+		return false;
+	}
+
+	bool SudokuBoard::pointingRowReduction(int round){
+		for (int item=nextUnchecked(POINTING_ROW_WORK, 0); item!=-1; item=nextUnchecked(POINTING_ROW_WORK, item+1)){
+			int valIndex = item/ROW_COL_SEC_SIZE;
+			int section = item%ROW_COL_SEC_SIZE;
+			int secStart = sectionToFirstCell(section);
+			bool inOneRow = true;
+			int boxRow = -1;
+			for (int j=0; j<GRID_SIZE; j++){
+				{for (int i=0; i<GRID_SIZE; i++){
+					int secVal=secStart+i+(ROW_COL_SEC_SIZE*j);
+					if (isPossible(secVal, valIndex)){
+						if (boxRow == -1 || boxRow == j){
+							boxRow = j;
+						} else {
+							inOneRow = false;
 						}
-					}}
-					if (doneSomething){
-						if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::ROW_BOX, valIndex+1, rowStart));
-						return true;
 					}
+				}}
+			}
+			if (inOneRow && boxRow != -1){
+				bool doneSomething = false;
+				int row = cellToRow(secStart) + boxRow;
+				int rowStart = rowToFirstCell(row);
+
+				{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
+					int position = rowStart+i;
+					int section2 = cellToSection(position);
+					if (section != section2 && eliminatePossibility(position, valIndex, round)){
+						doneSomething = true;
+					}
+				}}
+				if (doneSomething){
+					if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::POINTING_PAIR_TRIPLE_ROW, valIndex+1, rowStart));
+					return true;
 				}
 			}
+			checked(POINTING_ROW_WORK, item);
 		}
 		return false;
 	}
 
-	bool SudokuBoard::pointingRowReduction(int round){
-		for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-			for (int section=0; section<ROW_COL_SEC_SIZE; section++){
-				int secStart = sectionToFirstCell(section);
-				bool inOneRow = true;
-				int boxRow = -1;
+	bool SudokuBoard::pointingColumnReduction(int round){
+		for (int item=nextUnchecked(POINTING_COLUMN_WORK, 0); item!=-1; item=nextUnchecked(POINTING_COLUMN_WORK, item+1)){
+			int valIndex = item/ROW_COL_SEC_SIZE;
+			int section = item%ROW_COL_SEC_SIZE;
+			int secStart = sectionToFirstCell(section);
+			bool inOneCol = true;
+			int boxCol = -1;
+			{for (int i=0; i<GRID_SIZE; i++){
 				for (int j=0; j<GRID_SIZE; j++){
-					{for (int i=0; i<GRID_SIZE; i++){
-						int secVal=secStart+i+(ROW_COL_SEC_SIZE*j);
-						int valPos = getPossibilityIndex(valIndex,secVal);
-						if(possibilities[valPos] == 0){
-							if (boxRow == -1 || boxRow == j){
-								boxRow = j;
-							} else {
-								inOneRow = false;
-							}
-						}
-					}}
-				}
-				if (inOneRow && boxRow != -1){
-					bool doneSomething = false;
-					int row = cellToRow(secStart) + boxRow;
-					int rowStart = rowToFirstCell(row);
-
-					{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
-						int position = rowStart+i;
-						int section2 = cellToSection(position);
-						int valPos = getPossibilityIndex(valIndex,position);
-						if (section != section2 && possibilities[valPos] == 0){
-							possibilities[valPos] = round;
-							doneSomething = true;
+					int secVal=secStart+i+(ROW_COL_SEC_SIZE*j);
+					if (isPossible(secVal, valIndex)){
+						if (boxCol == -1 || boxCol == i){
+							boxCol = i;
+						} else {
+							inOneCol = false;
 						}
-					}}
-					if (doneSomething){
-						if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::POINTING_PAIR_TRIPLE_ROW, valIndex+1, rowStart));
-						return true;
 					}
 				}
-			}
-		}
-		return false;
-	}
+			}}
+			if (inOneCol && boxCol != -1){
+				bool doneSomething = false;
+				int col = cellToColumn(secStart) + boxCol;
+				int colStart = columnToFirstCell(col);
 
-	bool SudokuBoard::pointingColumnReduction(int round){
-		for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-			for (int section=0; section<ROW_COL_SEC_SIZE; section++){
-				int secStart = sectionToFirstCell(section);
-				bool inOneCol = true;
-				int boxCol = -1;
-				{for (int i=0; i<GRID_SIZE; i++){
-					for (int j=0; j<GRID_SIZE; j++){
-						int secVal=secStart+i+(ROW_COL_SEC_SIZE*j);
-						int valPos = getPossibilityIndex(valIndex,secVal);
-						if(possibilities[valPos] == 0){
-							if (boxCol == -1 || boxCol == i){
-								boxCol = i;
-							} else {
-								inOneCol = false;
-							}
-						}
+				{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
+					int position = colStart+(ROW_COL_SEC_SIZE*i);
+					int section2 = cellToSection(position);
+					if (section != section2 && eliminatePossibility(position, valIndex, round)){
+						doneSomething = true;
 					}
 				}}
-				if (inOneCol && boxCol != -1){
-					bool doneSomething = false;
-					int col = cellToColumn(secStart) + boxCol;
-					int colStart = columnToFirstCell(col);
-
-					{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
-						int position = colStart+(ROW_COL_SEC_SIZE*i);
-						int section2 = cellToSection(position);
-						int valPos = getPossibilityIndex(valIndex,position);
-						if (section != section2 && possibilities[valPos] == 0){
-							possibilities[valPos] = round;
-							doneSomething = true;
-						}
-					}}
-					if (doneSomething){
-						if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::POINTING_PAIR_TRIPLE_COLUMN, valIndex+1, colStart));
-						return true;
-					}
+				if (doneSomething){
+					if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::POINTING_PAIR_TRIPLE_COLUMN, valIndex+1, colStart));
+					return true;
 				}
 			}
+			checked(POINTING_COLUMN_WORK, item);
 		}
 		return false;
 	}
 
 	int SudokuBoard::countPossibilities(int position){
-		int count = 0;
-		for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-			int valPos = getPossibilityIndex(valIndex,position);
-			if (possibilities[valPos] == 0) count++;
-		}
-		return count;
+		return countBits(candidates[position]);
 	}
 
 	bool SudokuBoard::arePossibilitiesSame(int position1, int position2){
-		for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-			int valPos1 = getPossibilityIndex(valIndex,position1);
-			int valPos2 = getPossibilityIndex(valIndex,position2);
-			if ((possibilities[valPos1] == 0 || possibilities[valPos2] == 0) && (possibilities[valPos1] != 0 || possibilities[valPos2] != 0)){
-				return false;
-			}
-		}
-		return true;
+		return candidates[position1] == candidates[position2];
 	}
 
 	bool SudokuBoard::removePossibilitiesInOneFromTwo(int position1, int position2, int round){
 		bool doneSomething = false;
-		for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-			int valPos1 = getPossibilityIndex(valIndex,position1);
-			int valPos2 = getPossibilityIndex(valIndex,position2);
-			if (possibilities[valPos1] == 0 && possibilities[valPos2] == 0){
-				possibilities[valPos2] = round;
-				doneSomething = true;
-			}
+		unsigned int common = candidates[position1] & candidates[position2];
+		while (common != 0){
+			eliminatePossibility(position2, lowestBitIndex(common), round);
+			common &= common-1;
+			doneSomething = true;
 		}
 		return doneSomething;
 	}
 
 	bool SudokuBoard::hiddenPairInColumn(int round){
-		for (int column=0; column<ROW_COL_SEC_SIZE; column++){
+		for (int column=nextUnchecked(HIDDEN_PAIR_COLUMN_WORK, 0); column!=-1; column=nextUnchecked(HIDDEN_PAIR_COLUMN_WORK, column+1)){
 			for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
 				int r1 = -1;
 				int r2 = -1;
 				int valCount = 0;
 				for (int row=0; row<ROW_COL_SEC_SIZE; row++){
 					int position = rowColumnToCell(row,column);
-					int valPos = getPossibilityIndex(valIndex,position);
-					if (possibilities[valPos] == 0){
+					if (isPossible(position, valIndex)){
 						if (r1 == -1 || r1 == row){
 							r1 = row;
 						} else if (r2 == -1 || r2 == row){
@@ -940,8 +2422,7 @@ namespace qqwing {
 						int valCount2 = 0;
 						for (int row=0; row<ROW_COL_SEC_SIZE; row++){
 							int position = rowColumnToCell(row,column);
-							int valPos = getPossibilityIndex(valIndex2,position);
-							if (possibilities[valPos] == 0){
+							if (isPossible(position, valIndex2)){
 								if (r3 == -1 || r3 == row){
 									r3 = row;
 								} else if (r4 == -1 || r4 == row){
@@ -956,40 +2437,36 @@ namespace qqwing {
 								if (valIndex3 != valIndex && valIndex3 != valIndex2){
 									int position1 = rowColumnToCell(r1,column);
 									int position2 = rowColumnToCell(r2,column);
-									int valPos1 = getPossibilityIndex(valIndex3,position1);
-									int valPos2 = getPossibilityIndex(valIndex3,position2);
-									if (possibilities[valPos1] == 0){
-										possibilities[valPos1] = round;
+									if (eliminatePossibility(position1, valIndex3, round)){
 										doneSomething = true;
 									}
-									if (possibilities[valPos2] == 0){
-										possibilities[valPos2] = round;
+									if (eliminatePossibility(position2, valIndex3, round)){
 										doneSomething = true;
 									}
 								}
 							}
 							if (doneSomething){
-								if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::HIDDEN_PAIR_COLUMN, valIndex+1, rowColumnToCell(r1,column)));
+								if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::HIDDEN_PAIR_COLUMN, valIndex+1, rowColumnToCell(r1,column)));
 								return true;
 							}
 						}
 					}
 				}
 			}
+			checked(HIDDEN_PAIR_COLUMN_WORK, column);
 		}
 		return false;
 	}
 
 	bool SudokuBoard::hiddenPairInSection(int round){
-		for (int section=0; section<ROW_COL_SEC_SIZE; section++){
+		for (int section=nextUnchecked(HIDDEN_PAIR_SECTION_WORK, 0); section!=-1; section=nextUnchecked(HIDDEN_PAIR_SECTION_WORK, section+1)){
 			for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
 				int si1 = -1;
 				int si2 = -1;
 				int valCount = 0;
 				for (int secInd=0; secInd<ROW_COL_SEC_SIZE; secInd++){
 					int position = sectionToCell(section,secInd);
-					int valPos = getPossibilityIndex(valIndex,position);
-					if (possibilities[valPos] == 0){
+					if (isPossible(position, valIndex)){
 						if (si1 == -1 || si1 == secInd){
 							si1 = secInd;
 						} else if (si2 == -1 || si2 == secInd){
@@ -1005,8 +2482,7 @@ namespace qqwing {
 						int valCount2 = 0;
 						for (int secInd=0; secInd<ROW_COL_SEC_SIZE; secInd++){
 							int position = sectionToCell(section,secInd);
-							int valPos = getPossibilityIndex(valIndex2,position);
-							if (possibilities[valPos] == 0){
+							if (isPossible(position, valIndex2)){
 								if (si3 == -1 || si3 == secInd){
 									si3 = secInd;
 								} else if (si4 == -1 || si4 == secInd){
@@ -1021,40 +2497,36 @@ namespace qqwing {
 								if (valIndex3 != valIndex && valIndex3 != valIndex2){
 									int position1 = sectionToCell(section,si1);
 									int position2 = sectionToCell(section,si2);
-									int valPos1 = getPossibilityIndex(valIndex3,position1);
-									int valPos2 = getPossibilityIndex(valIndex3,position2);
-									if (possibilities[valPos1] == 0){
-										possibilities[valPos1] = round;
+									if (eliminatePossibility(position1, valIndex3, round)){
 										doneSomething = true;
 									}
-									if (possibilities[valPos2] == 0){
-										possibilities[valPos2] = round;
+									if (eliminatePossibility(position2, valIndex3, round)){
 										doneSomething = true;
 									}
 								}
 							}
 							if (doneSomething){
-								if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::HIDDEN_PAIR_SECTION, valIndex+1, sectionToCell(section,si1)));
+								if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::HIDDEN_PAIR_SECTION, valIndex+1, sectionToCell(section,si1)));
 								return true;
 							}
 						}
 					}
 				}
 			}
+			checked(HIDDEN_PAIR_SECTION_WORK, section);
 		}
 		return false;
 	}
 
 	bool SudokuBoard::hiddenPairInRow(int round){
-		for (int row=0; row<ROW_COL_SEC_SIZE; row++){
+		for (int row=nextUnchecked(HIDDEN_PAIR_ROW_WORK, 0); row!=-1; row=nextUnchecked(HIDDEN_PAIR_ROW_WORK, row+1)){
 			for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
 				int c1 = -1;
 				int c2 = -1;
 				int valCount = 0;
 				for (int column=0; column<ROW_COL_SEC_SIZE; column++){
 					int position = rowColumnToCell(row,column);
-					int valPos = getPossibilityIndex(valIndex,position);
-					if (possibilities[valPos] == 0){
+					if (isPossible(position, valIndex)){
 						if (c1 == -1 || c1 == column){
 							c1 = column;
 						} else if (c2 == -1 || c2 == column){
@@ -1070,8 +2542,7 @@ namespace qqwing {
 						int valCount2 = 0;
 						for (int column=0; column<ROW_COL_SEC_SIZE; column++){
 							int position = rowColumnToCell(row,column);
-							int valPos = getPossibilityIndex(valIndex2,position);
-							if (possibilities[valPos] == 0){
+							if (isPossible(position, valIndex2)){
 								if (c3 == -1 || c3 == column){
 									c3 = column;
 								} else if (c4 == -1 || c4 == column){
@@ -1086,32 +2557,29 @@ namespace qqwing {
 								if (valIndex3 != valIndex && valIndex3 != valIndex2){
 									int position1 = rowColumnToCell(row,c1);
 									int position2 = rowColumnToCell(row,c2);
-									int valPos1 = getPossibilityIndex(valIndex3,position1);
-									int valPos2 = getPossibilityIndex(valIndex3,position2);
-									if (possibilities[valPos1] == 0){
-										possibilities[valPos1] = round;
+									if (eliminatePossibility(position1, valIndex3, round)){
 										doneSomething = true;
 									}
-									if (possibilities[valPos2] == 0){
-										possibilities[valPos2] = round;
+									if (eliminatePossibility(position2, valIndex3, round)){
 										doneSomething = true;
 									}
 								}
 							}
 							if (doneSomething){
-								if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::HIDDEN_PAIR_ROW, valIndex+1, rowColumnToCell(row,c1)));
+								if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::HIDDEN_PAIR_ROW, valIndex+1, rowColumnToCell(row,c1)));
 								return true;
 							}
 						}
 					}
 				}
 			}
+			checked(HIDDEN_PAIR_ROW_WORK, row);
 		}
 		return false;
 	}
 
 	bool SudokuBoard::handleNakedPairs(int round){
-		for (int position=0; position<BOARD_SIZE; position++){
+		for (int position=nextUnchecked(NAKED_PAIR_WORK, 0); position!=-1; position=nextUnchecked(NAKED_PAIR_WORK, position+1)){
 			int possibilities = countPossibilities(position);
 			if (possibilities == 2){
 				int row = cellToRow(position);
@@ -1130,7 +2598,7 @@ namespace qqwing {
 									}
 								}
 								if (doneSomething){
-									if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::NAKED_PAIR_ROW, 0, position));
+									if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::NAKED_PAIR_ROW, 0, position));
 									return true;
 								}
 							}
@@ -1143,7 +2611,7 @@ namespace qqwing {
 									}
 								}
 								if (doneSomething){
-									if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::NAKED_PAIR_COLUMN, 0, position));
+									if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::NAKED_PAIR_COLUMN, 0, position));
 									return true;
 								}
 							}
@@ -1159,7 +2627,7 @@ namespace qqwing {
 									}
 								}}
 								if (doneSomething){
-									if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::NAKED_PAIR_SECTION, 0, position));
+									if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::NAKED_PAIR_SECTION, 0, position));
 									return true;
 								}
 							}
@@ -1167,6 +2635,7 @@ namespace qqwing {
 					}
 				}
 			}
+			checked(NAKED_PAIR_WORK, position);
 		}
 		return false;
 	}
@@ -1178,27 +2647,20 @@ namespace qqwing {
 	 * for one cell.  This type of cell is often called a "hidden single"
 	 */
 	bool SudokuBoard::onlyValueInRow(int round){
-		for (int row=0; row<ROW_COL_SEC_SIZE; row++){
-			for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-				int count = 0;
-				int lastPosition = 0;
-				for (int col=0; col<ROW_COL_SEC_SIZE; col++){
-					int position = (row*ROW_COL_SEC_SIZE)+col;
-					int valPos = getPossibilityIndex(valIndex,position);
-					if (possibilities[valPos] == 0){
-						count++;
-						lastPosition = position;
-					}
-				}
-				if (count == 1){
-					int value = valIndex+1;
-					if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::HIDDEN_SINGLE_ROW, value, lastPosition));
-					mark(lastPosition, round, value);
-					return true;
-				}
+		int unitValue = findHiddenSingle(ROW_UNITS);
+		if (unitValue == -1) return false;
+		int row = unitValue/ROW_COL_SEC_SIZE;
+		int valIndex = unitValue%ROW_COL_SEC_SIZE;
+		for (int col=0; col<ROW_COL_SEC_SIZE; col++){
+			int position = rowColumnToCell(row,col);
+			if (isPossible(position, valIndex)){
+				int value = valIndex+1;
+				if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::HIDDEN_SINGLE_ROW, value, position));
+				mark(position, round, value);
+				return true;
 			}
 		}
-		return false;
+		throw ("Hidden single in row has no possible position.");
 	}
 
 	/**
@@ -1208,27 +2670,20 @@ namespace qqwing {
 	 * for one cell.  This type of cell is often called a "hidden single"
 	 */
 	bool SudokuBoard::onlyValueInColumn(int round){
-		for (int col=0; col<ROW_COL_SEC_SIZE; col++){
-			for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-				int count = 0;
-				int lastPosition = 0;
-				for (int row=0; row<ROW_COL_SEC_SIZE; row++){
-					int position = rowColumnToCell(row,col);
-					int valPos = getPossibilityIndex(valIndex,position);
-					if (possibilities[valPos] == 0){
-						count++;
-						lastPosition = position;
-					}
-				}
-				if (count == 1){
-					int value = valIndex+1;
-					if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::HIDDEN_SINGLE_COLUMN, value, lastPosition));
-					mark(lastPosition, round, value);
-					return true;
-				}
+		int unitValue = findHiddenSingle(COLUMN_UNITS);
+		if (unitValue == -1) return false;
+		int col = unitValue/ROW_COL_SEC_SIZE-COLUMN_UNITS;
+		int valIndex = unitValue%ROW_COL_SEC_SIZE;
+		for (int row=0; row<ROW_COL_SEC_SIZE; row++){
+			int position = rowColumnToCell(row,col);
+			if (isPossible(position, valIndex)){
+				int value = valIndex+1;
+				if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::HIDDEN_SINGLE_COLUMN, value, position));
+				mark(position, round, value);
+				return true;
 			}
 		}
-		return false;
+		throw ("Hidden single in column has no possible position.");
 	}
 
 	/**
@@ -1238,30 +2693,160 @@ namespace qqwing {
 	 * for one cell.  This type of cell is often called a "hidden single"
 	 */
 	bool SudokuBoard::onlyValueInSection(int round){
-		for (int sec=0; sec<ROW_COL_SEC_SIZE; sec++){
-			int secPos = sectionToFirstCell(sec);
-			for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-				int count = 0;
-				int lastPosition = 0;
-				{for (int i=0; i<GRID_SIZE; i++){
-					for (int j=0; j<GRID_SIZE; j++){
-						int position = secPos + i + ROW_COL_SEC_SIZE*j;
-						int valPos = getPossibilityIndex(valIndex,position);
-						if (possibilities[valPos] == 0){
-							count++;
-							lastPosition = position;
-						}
-					}
-				}}
-				if (count == 1){
-					int value = valIndex+1;
-					if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::HIDDEN_SINGLE_SECTION, value, lastPosition));
-					mark(lastPosition, round, value);
-					return true;
-				}
+		int unitValue = findHiddenSingle(SECTION_UNITS);
+		if (unitValue == -1) return false;
+		int sec = unitValue/ROW_COL_SEC_SIZE-SECTION_UNITS;
+		int valIndex = unitValue%ROW_COL_SEC_SIZE;
+		for (int secInd=0; secInd<ROW_COL_SEC_SIZE; secInd++){
+			int position = sectionToCell(sec,secInd);
+			if (isPossible(position, valIndex)){
+				int value = valIndex+1;
+				if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::HIDDEN_SINGLE_SECTION, value, position));
+				mark(position, round, value);
+				return true;
 			}
 		}
-		return false;
+		throw ("Hidden single in section has no possible position.");
+	}
+
+	/**
+	 * Find the first row, column, or section (in that order starting
+	 * from the given unit) that has a value which is possible in only
+	 * one of its squares.  The unit counts are kept up to date as
+	 * possibilities are removed and restored, so this does not need to
+	 * look at the board at all.
+	 *
+	 * @param firstUnit ROW_UNITS, COLUMN_UNITS, or SECTION_UNITS
+	 * @return unit*9+valIndex for the hidden single, or -1 if there is none
+	 */
+	int SudokuBoard::findHiddenSingle(int firstUnit){
+		int first = firstUnit*ROW_COL_SEC_SIZE;
+		int unitValue = nextInSet(hiddenSingles, HIDDEN_SINGLE_WORDS, first);
+		return (unitValue < first+BOARD_SIZE)?unitValue:-1;
+	}
+
+	/**
+	 * A possibility for the value at the given position has been removed.
+	 * Update the count of squares left for the value in the row, column,
+	 * and section of the position.
+	 */
+	inline void SudokuBoard::removeFromUnitCounts(int position, int valIndex){
+		decrementUnitValueCount(ROW_UNITS+cellToRow(position), valIndex);
+		decrementUnitValueCount(COLUMN_UNITS+cellToColumn(position), valIndex);
+		decrementUnitValueCount(SECTION_UNITS+cellToSection(position), valIndex);
+	}
+
+	/**
+	 * A possibility for the value at the given position has been restored.
+	 * Update the count of squares left for the value in the row, column,
+	 * and section of the position.
+	 */
+	inline void SudokuBoard::restoreToUnitCounts(int position, int valIndex){
+		incrementUnitValueCount(ROW_UNITS+cellToRow(position), valIndex);
+		incrementUnitValueCount(COLUMN_UNITS+cellToColumn(position), valIndex);
+		incrementUnitValueCount(SECTION_UNITS+cellToSection(position), valIndex);
+	}
+
+	inline void SudokuBoard::decrementUnitValueCount(int unit, int valIndex){
+		int unitValue = unit*ROW_COL_SEC_SIZE+valIndex;
+		int count = --unitValueCounts[unitValue];
+		if (count == 1){
+			addToSet(hiddenSingles, unitValue);
+		} else if (count == 0){
+			removeFromSet(hiddenSingles, unitValue);
+		}
+	}
+
+	inline void SudokuBoard::incrementUnitValueCount(int unit, int valIndex){
+		int unitValue = unit*ROW_COL_SEC_SIZE+valIndex;
+		int count = ++unitValueCounts[unitValue];
+		if (count == 1){
+			addToSet(hiddenSingles, unitValue);
+		} else if (count == 2){
+			removeFromSet(hiddenSingles, unitValue);
+		}
+	}
+
+	/**
+	 * The first item at or after the given one on a strategy's
+	 * worklist, or -1 if there are no more.
+	 */
+	inline int SudokuBoard::nextUnchecked(int worklist, int from){
+		return nextInSet(&worklists[worklist*SQUARE_SET_WORDS], SQUARE_SET_WORDS, from);
+	}
+
+	/**
+	 * A strategy looked at an item on its worklist and found
+	 * nothing to do there.
+	 */
+	inline void SudokuBoard::checked(int worklist, int item){
+		removeFromSet(&worklists[worklist*SQUARE_SET_WORDS], item);
+	}
+
+	/**
+	 * The possibilities for the value bits in changed were removed from
+	 * or restored to the given position.  Keep track of squares that
+	 * have one possibility left, and remember the change so that the
+	 * strategy worklists can be brought up to date the next time they
+	 * are needed.  Most changes happen while marking values and are
+	 * followed by a single or hidden single, so the worklists are not
+	 * updated here.
+	 */
+	inline void SudokuBoard::possibilitiesChanged(int position, unsigned int changed){
+		if (countBits(candidates[position]) == 1){
+			addToSet(nakedSingles, position);
+		} else {
+			removeFromSet(nakedSingles, position);
+		}
+		if (pendingChanges[position] == 0) addToSet(changedSquares, position);
+		pendingChanges[position] |= changed;
+	}
+
+	/**
+	 * Put everything that could be affected by the changes since the
+	 * last call back on the strategy worklists.
+	 */
+	void SudokuBoard::updateWorklists(){
+		for (int position=nextInSet(changedSquares, SQUARE_SET_WORDS, 0); position!=-1; position=nextInSet(changedSquares, SQUARE_SET_WORDS, position+1)){
+			unsigned int changed = pendingChanges[position];
+			pendingChanges[position] = 0;
+			removeFromSet(changedSquares, position);
+			addToWorklists(position, changed);
+		}
+	}
+
+	/**
+	 * Put everything that could be affected by a change to the
+	 * possibilities for the given values at the given position
+	 * back on the strategy worklists.
+	 */
+	void SudokuBoard::addToWorklists(int position, unsigned int changed){
+		{for (int i=0; i<SQUARE_SET_WORDS; i++){
+			worklists[NAKED_PAIR_WORK*SQUARE_SET_WORDS+i] |= peerSets.squares[position][i];
+		}}
+		int row = cellToRow(position);
+		int column = cellToColumn(position);
+		int section = cellToSection(position);
+		addToSet(&worklists[HIDDEN_PAIR_ROW_WORK*SQUARE_SET_WORDS], row);
+		addToSet(&worklists[HIDDEN_PAIR_COLUMN_WORK*SQUARE_SET_WORDS], column);
+		addToSet(&worklists[HIDDEN_PAIR_SECTION_WORK*SQUARE_SET_WORDS], section);
+
+		// Box/line strategies look at one value across a band
+		// (three sections side by side) or a stack (three sections
+		// one above the other).
+		int bandStart = row/GRID_SIZE*GRID_SIZE;
+		int stackStart = column/GRID_SIZE*GRID_SIZE;
+		int stackSection = column/GRID_SIZE;
+		while (changed != 0){
+			int item = lowestBitIndex(changed)*ROW_COL_SEC_SIZE;
+			changed &= changed-1;
+			{for (int i=0; i<GRID_SIZE; i++){
+				addToSet(&worklists[POINTING_ROW_WORK*SQUARE_SET_WORDS], item+bandStart+i);
+				addToSet(&worklists[POINTING_COLUMN_WORK*SQUARE_SET_WORDS], item+stackSection+i*GRID_SIZE);
+				addToSet(&worklists[ROW_BOX_WORK*SQUARE_SET_WORDS], item+bandStart+i);
+				addToSet(&worklists[COLUMN_BOX_WORK*SQUARE_SET_WORDS], item+stackStart+i);
+			}}
+		}
 	}
 
 	/**
@@ -1270,25 +2855,12 @@ namespace qqwing {
 	 * of cell is often called a "single"
 	 */
 	bool SudokuBoard::onlyPossibilityForCell(int round){
-		for (int position=0; position<BOARD_SIZE; position++){
-			if (solution[position] == 0){
-				int count = 0;
-				int lastValue = 0;
-				for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-					int valPos = getPossibilityIndex(valIndex,position);
-					if (possibilities[valPos] == 0){
-						count++;
-						lastValue=valIndex+1;
-					}
-				}
-				if (count == 1){
-					mark(position, round, lastValue);
-					if (logHistory || recordHistory) addHistoryItem(new LogItem(round, LogItem::SINGLE, lastValue, position));
-					return true;
-				}
-			}
-		}
-		return false;
+		int position = nextInSet(nakedSingles, SQUARE_SET_WORDS, 0);
+		if (position == -1) return false;
+		int lastValue = lowestBitIndex(candidates[position])+1;
+		mark(position, round, lastValue);
+		if (logHistory || recordHistory) addHistoryItem(LogItem(round, LogItem::SINGLE, lastValue, position));
+		return true;
 	}
 
 	/**
@@ -1302,56 +2874,76 @@ namespace qqwing {
 	 */
 	void SudokuBoard::mark(int position, int round, int value){
 		if (solution[position] != 0) throw ("Marking position that already has been marked.");
-		if (solutionRound[position] !=0) throw ("Marking position that was marked another round.");
 		int valIndex = value-1;
-		solution[position] = value;
+		if (!isPossible(position, valIndex)) throw ("Marking impossible position.");
+		if (profiling) profile.marks++;
 
-		int possInd = getPossibilityIndex(valIndex,position);
-		if (possibilities[possInd] != 0) throw ("Marking impossible position.");
+		//This position itself is determined, it should have no possibilities.
+		solution[position] = value;
+		solvedCount++;
+		pushTrailEntry(round, position, candidates[position]);
+		unsigned int removed = candidates[position];
+		candidates[position] = 0;
+		possibilitiesChanged(position, removed);
+		while (removed != 0){
+			removeFromUnitCounts(position, lowestBitIndex(removed));
+			removed &= removed-1;
+		}
 
 		// Take this value out of the possibilities for everything in the row
-		solutionRound[position] = round;
 		int rowStart = cellToRow(position)*ROW_COL_SEC_SIZE;
 		for (int col=0; col<ROW_COL_SEC_SIZE; col++){
-			int rowVal=rowStart+col;
-			int valPos = getPossibilityIndex(valIndex,rowVal);
-			//cout << "Row Start: " << rowStart << " Row Value: " << rowVal << " Value Position: " << valPos << endl;
-			if (possibilities[valPos] == 0){
-				possibilities[valPos] = round;
-			}
+			eliminatePossibility(rowStart+col, valIndex, round);
 		}
 
 		// Take this value out of the possibilities for everything in the column
 		int colStart = cellToColumn(position);
 		{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
-			int colVal=colStart+(ROW_COL_SEC_SIZE*i);
-			int valPos = getPossibilityIndex(valIndex,colVal);
-			//cout << "Col Start: " << colStart << " Col Value: " << colVal << " Value Position: " << valPos << endl;
-			if (possibilities[valPos] == 0){
-				possibilities[valPos] = round;
-			}
+			eliminatePossibility(colStart+(ROW_COL_SEC_SIZE*i), valIndex, round);
 		}}
 
 		// Take this value out of the possibilities for everything in section
 		int secStart = cellToSectionStartCell(position);
 		{for (int i=0; i<GRID_SIZE; i++){
 			for (int j=0; j<GRID_SIZE; j++){
-				int secVal=secStart+i+(ROW_COL_SEC_SIZE*j);
-				int valPos = getPossibilityIndex(valIndex,secVal);
-				//cout << "Sec Start: " << secStart << " Sec Value: " << secVal << " Value Position: " << valPos << endl;
-				if (possibilities[valPos] == 0){
-					possibilities[valPos] = round;
-				}
+				eliminatePossibility(secStart+i+(ROW_COL_SEC_SIZE*j), valIndex, round);
 			}
 		}}
+	}
 
-		//This position itself is determined, it should have possibilities.
-		{for (int valIndex=0; valIndex<ROW_COL_SEC_SIZE; valIndex++){
-			int valPos = getPossibilityIndex(valIndex,position);
-			if (possibilities[valPos] == 0){
-				possibilities[valPos] = round;
-			}
-		}}
+	/**
+	 * Return true if the value (0-8) is still a possibility
+	 * for the cell at the given position.
+	 */
+	inline bool SudokuBoard::isPossible(int position, int valIndex){
+		return (candidates[position] & valueIndexToBit(valIndex)) != 0;
+	}
+
+	/**
+	 * Remove the value (0-8) from the possibilities for the cell
+	 * at the given position, recording the change on the trail
+	 * so that it can be rolled back.  Return true if the
+	 * value was still a possibility before this call.
+	 */
+	inline bool SudokuBoard::eliminatePossibility(int position, int valIndex, int round){
+		unsigned short bit = valueIndexToBit(valIndex);
+		if ((candidates[position] & bit) == 0) return false;
+		candidates[position] &= ~bit;
+		if (candidates[position] == 0) emptyCount++;
+		possibilitiesChanged(position, bit);
+		removeFromUnitCounts(position, valIndex);
+		pushTrailEntry(round, position, bit);
+		return true;
+	}
+
+	/**
+	 * Record a change to the board on the trail.
+	 */
+	inline void SudokuBoard::pushTrailEntry(int round, int position, unsigned short removed){
+		TrailEntry& entry = trail[trailSize++];
+		entry.round = (unsigned char)round;
+		entry.position = (unsigned char)position;
+		entry.removed = removed;
 	}
 
 	/**
@@ -1359,94 +2951,329 @@ namespace qqwing {
 	 * as a sudoku puzzle.  Use print options from
 	 * member variables.
 	 */
-	void SudokuBoard::print(int* sudoku){
+	void SudokuBoard::print(ostream& out, int* sudoku){
+		// Format the whole board and write it at once,
+		// rather than a character at a time
+		static const char SQUARES[] = ".123456789";
+		char text[512];
+		int length = 0;
 		for(int i=0; i<BOARD_SIZE; i++){
 			if (printStyle == READABLE){
-				cout << " ";
-			}
-			if (sudoku[i]==0){
-				cout << '.';
-			} else {
-				cout << sudoku[i];
+				text[length++] = ' ';
 			}
+			text[length++] = SQUARES[sudoku[i]];
 			if (i == BOARD_SIZE-1){
 				if (printStyle == CSV){
-					cout << ",";
+					text[length++] = ',';
 				} else {
-					cout << endl;
+					text[length++] = '\n';
 				}
 				if (printStyle == READABLE || printStyle == COMPACT){
-					cout << endl;
+					text[length++] = '\n';
 				}
 			} else if (i%ROW_COL_SEC_SIZE==ROW_COL_SEC_SIZE-1){
 				if (printStyle == READABLE || printStyle == COMPACT){
-					cout << endl;
+					text[length++] = '\n';
 				}
 				if (i%SEC_GROUP_SIZE==SEC_GROUP_SIZE-1){
 					if (printStyle == READABLE){
-						cout << "-------|-------|-------" << endl;
+						const char* line = "-------|-------|-------\n";
+						memcpy(text+length, line, 24);
+						length += 24;
 					}
 				}
 			} else if (i%GRID_SIZE==GRID_SIZE-1){
 				if (printStyle == READABLE){
-					cout << " |";
+					text[length++] = ' ';
+					text[length++] = '|';
 				}
 			}
 		}
+		out.write(text, length);
 	}
 
 	/**
 	 * Print the sudoku puzzle.
 	 */
 	void SudokuBoard::printPuzzle(){
-		print(puzzle);
+		printPuzzle(cout);
+	}
+
+	void SudokuBoard::printPuzzle(ostream& out){
+		print(out, puzzle);
 	}
 
 	/**
 	 * Print the sudoku solution.
 	 */
 	void SudokuBoard::printSolution(){
-		print(solution);
+		printSolution(cout);
+	}
+
+	void SudokuBoard::printSolution(ostream& out){
+		print(out, solution);
+	}
+
+	#if QQWING_PARSE_SSE2 == 1
+		/**
+		 * Parse 16 squares at once, if all of the characters
+		 * are digits or periods.
+		 */
+		static inline bool parseSquares(const char* text, int* values){
+			__m128i chars = _mm_loadu_si128((const __m128i*)text);
+			__m128i digits = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+			__m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+			__m128i isPeriod = _mm_cmpeq_epi8(chars, _mm_set1_epi8('.'));
+			if (_mm_movemask_epi8(_mm_or_si128(isDigit, isPeriod)) != 0xFFFF) return false;
+			digits = _mm_and_si128(digits, isDigit);
+			__m128i zero = _mm_setzero_si128();
+			__m128i low = _mm_unpacklo_epi8(digits, zero);
+			__m128i high = _mm_unpackhi_epi8(digits, zero);
+			_mm_storeu_si128((__m128i*)values, _mm_unpacklo_epi16(low, zero));
+			_mm_storeu_si128((__m128i*)(values+4), _mm_unpackhi_epi16(low, zero));
+			_mm_storeu_si128((__m128i*)(values+8), _mm_unpacklo_epi16(high, zero));
+			_mm_storeu_si128((__m128i*)(values+12), _mm_unpackhi_epi16(high, zero));
+			return true;
+		}
+	#endif
+
+	/**
+	 * Whether a character is a square of a puzzle:
+	 * a digit, or a period for an unknown.
+	 */
+	static inline bool isSquare(char c){
+		return (c >= '0' && c <= '9') || c == '.';
 	}
 
-	SudokuBoard::~SudokuBoard(){
-		clearPuzzle();
-		delete[] puzzle;
-		delete[] solution;
-		delete[] possibilities;
-		delete[] solutionRound;
-		delete[] randomBoardArray;
-		delete[] randomPossibilityArray;
-		delete solveHistory;
-		delete solveInstructions;
+	/**
+	 * Most puzzles are 81 digits and periods in a row, one
+	 * to a line, and those are checked and converted 16 at a
+	 * time where possible.  Anything else is parsed one
+	 * character at a time.
+	 */
+	size_t parsePuzzle(const char* text, size_t length, int* puzzle){
+		size_t i = 0;
+		while (i < length && !isSquare(text[i])) i++;
+		#if QQWING_PARSE_SSE2 == 1
+			if (length-i >= (size_t)BOARD_SIZE
+					&& isSquare(text[i+BOARD_SIZE-1])
+					&& parseSquares(text+i, puzzle)
+					&& parseSquares(text+i+16, puzzle+16)
+					&& parseSquares(text+i+32, puzzle+32)
+					&& parseSquares(text+i+48, puzzle+48)
+					&& parseSquares(text+i+64, puzzle+64)){
+				char c = text[i+BOARD_SIZE-1];
+				puzzle[BOARD_SIZE-1] = (c == '.') ? 0 : c-'0';
+				return i+BOARD_SIZE;
+			}
+		#endif
+		int read = 0;
+		while (read < BOARD_SIZE && i < length){
+			char c = text[i++];
+			if (c >= '0' && c <= '9'){
+				puzzle[read] = c-'0';
+				read++;
+			} else if (c == '.'){
+				puzzle[read] = 0;
+				read++;
+			}
+		}
+		return (read == BOARD_SIZE) ? i : 0;
+	}
+
+	/**
+	 * Pack the 81 values of a board two to a byte,
+	 * the first in the high four bits.
+	 */
+	static void packBoard(const int* board, unsigned char* packed){
+		{for (int i=0; i<BINARY_BOARD_SIZE; i++){
+			int high = (board == NULL) ? 0 : board[2*i];
+			int low = (board == NULL || 2*i+1 >= BOARD_SIZE) ? 0 : board[2*i+1];
+			packed[i] = (unsigned char)((high<<4)|low);
+		}}
+	}
+
+	/**
+	 * Unpack a board packed by packBoard(), throwing
+	 * an error if any value is out of range.
+	 */
+	static void unpackBoard(const unsigned char* packed, int* board){
+		{for (int i=0; i<BOARD_SIZE; i++){
+			int value = (i%2 == 0) ? (packed[i/2]>>4) : (packed[i/2]&0xF);
+			if (value > ROW_COL_SEC_SIZE) throw "Bad value in binary puzzle file.";
+			board[i] = value;
+		}}
+	}
+
+	static int binaryRecordSize(bool solutions, bool stats){
+		return BINARY_BOARD_SIZE + (solutions ? BINARY_BOARD_SIZE : 0) + (stats ? BINARY_STATS_SIZE : 0);
+	}
+
+	BinaryPuzzleWriter::BinaryPuzzleWriter(bool sol, bool st){
+		solutions = sol;
+		stats = st;
+	}
+
+	int BinaryPuzzleWriter::getRecordSize() const {
+		return binaryRecordSize(solutions, stats);
+	}
+
+	void BinaryPuzzleWriter::writeHeader(ostream& out) const {
+		int recordSize = getRecordSize();
+		unsigned char header[BINARY_HEADER_SIZE] = {
+			'Q', 'Q', 'W', 'B',
+			(unsigned char)BINARY_FORMAT_VERSION,
+			(unsigned char)((solutions ? 1 : 0) | (stats ? 2 : 0)),
+			(unsigned char)(recordSize&0xFF),
+			(unsigned char)(recordSize>>8)
+		};
+		out.write((const char*)header, BINARY_HEADER_SIZE);
+	}
+
+	void BinaryPuzzleWriter::write(ostream& out, const int* puzzle, const int* solution, const SudokuBoard::Stats* st) const {
+		unsigned char record[2*BINARY_BOARD_SIZE+BINARY_STATS_SIZE];
+		unsigned char* next = record;
+		packBoard(puzzle, next);
+		next += BINARY_BOARD_SIZE;
+		if (solutions){
+			packBoard(solution, next);
+			next += BINARY_BOARD_SIZE;
+		}
+		if (stats){
+			int counts[] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+			int difficulty = SudokuBoard::UNKNOWN;
+			if (st != NULL){
+				counts[0] = st->givenCount;
+				counts[1] = st->singleCount;
+				counts[2] = st->hiddenSingleCount;
+				counts[3] = st->nakedPairCount;
+				counts[4] = st->hiddenPairCount;
+				counts[5] = st->pointingPairTripleCount;
+				counts[6] = st->boxLineReductionCount;
+				counts[7] = st->guessCount;
+				counts[8] = st->backtrackCount;
+				difficulty = st->difficulty;
+			}
+			{for (int i=0; i<9; i++){
+				int count = (counts[i] > 0xFFFF) ? 0xFFFF : counts[i];
+				*next++ = (unsigned char)(count&0xFF);
+				*next++ = (unsigned char)(count>>8);
+			}}
+			*next++ = (unsigned char)difficulty;
+		}
+		out.write((const char*)record, next-record);
+	}
+
+	BinaryPuzzleReader::BinaryPuzzleReader(istream& input) : in(input) {
+		solutions = false;
+		stats = false;
+		recordSize = BINARY_BOARD_SIZE;
+		unsigned char header[BINARY_HEADER_SIZE];
+		in.read((char*)header, BINARY_HEADER_SIZE);
+		if (in.gcount() == 0){
+			return;
+		}
+		if (in.gcount() != BINARY_HEADER_SIZE || header[0] != 'Q' || header[1] != 'Q' || header[2] != 'W' || header[3] != 'B'){
+			throw "Not a binary puzzle file.";
+		}
+		solutions = (header[5]&1) != 0;
+		stats = (header[5]&2) != 0;
+		recordSize = binaryRecordSize(solutions, stats);
+		if (header[4] != BINARY_FORMAT_VERSION || (header[5]&~3) != 0 || header[6]+(header[7]<<8) != recordSize){
+			throw "Unsupported version of the binary puzzle file format.";
+		}
+		record.resize(recordSize);
+	}
+
+	bool BinaryPuzzleReader::hasSolutions() const {
+		return solutions;
+	}
+
+	bool BinaryPuzzleReader::hasStats() const {
+		return stats;
+	}
+
+	int BinaryPuzzleReader::getRecordSize() const {
+		return recordSize;
+	}
+
+	bool BinaryPuzzleReader::read(int* puzzle, int* solution, SudokuBoard::Stats* st){
+		if (record.empty() || !in) return false;
+		in.read((char*)&record[0], recordSize);
+		if (in.gcount() == 0) return false;
+		if (in.gcount() != recordSize) throw "Binary puzzle file ends part way through a puzzle.";
+		const unsigned char* next = &record[0];
+		if (puzzle != NULL) unpackBoard(next, puzzle);
+		next += BINARY_BOARD_SIZE;
+		if (solution != NULL){
+			if (solutions){
+				unpackBoard(next, solution);
+			} else {
+				{for (int i=0; i<BOARD_SIZE; i++){
+					solution[i] = 0;
+				}}
+			}
+		}
+		if (solutions) next += BINARY_BOARD_SIZE;
+		if (st != NULL){
+			int counts[] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+			int difficulty = SudokuBoard::UNKNOWN;
+			if (stats){
+				{for (int i=0; i<9; i++){
+					counts[i] = next[2*i] | (next[2*i+1]<<8);
+				}}
+				difficulty = next[18];
+				if (difficulty > SudokuBoard::EXPERT) throw "Bad difficulty in binary puzzle file.";
+			}
+			st->givenCount = counts[0];
+			st->singleCount = counts[1];
+			st->hiddenSingleCount = counts[2];
+			st->nakedPairCount = counts[3];
+			st->hiddenPairCount = counts[4];
+			st->pointingPairTripleCount = counts[5];
+			st->boxLineReductionCount = counts[6];
+			st->guessCount = counts[7];
+			st->backtrackCount = counts[8];
+			st->difficulty = (SudokuBoard::Difficulty)difficulty;
+		}
+		return true;
 	}
 
-	LogItem::LogItem(int r, LogType t){
+	inline LogItem::LogItem(int r, LogType t){
 		init(r,t,0,-1);
 	}
 
-	LogItem::LogItem(int r, LogType t, int v, int p){
+	inline LogItem::LogItem(int r, LogType t, int v, int p){
 		init(r,t,v,p);
 	}
 
-	void LogItem::init(int r, LogType t, int v, int p){
+	inline void LogItem::init(int r, LogType t, int v, int p){
 		round = r;
 		type = t;
 		value = v;
 		position = p;
 	}
 
-	LogItem::~LogItem(){
+	/**
+	 * Move this log item to where its position and value
+	 * end up when the board is transformed.  When rows are
+	 * swapped with columns, a step in a row becomes the same
+	 * step in a column, and the other way around.
+	 */
+	inline void LogItem::transform(const int* newPosition, const int* valueMap, bool transpose){
+		if (position > -1) position = newPosition[position];
+		value = valueMap[value];
+		if (transpose) type = transposeLogType(type);
 	}
 
-	int LogItem::getRound(){
+	inline int LogItem::getRound() const {
 		return round;
 	}
 
 	/**
 	 * Get the type of this log item.
 	 */
-	LogItem::LogType LogItem::getType(){
+	inline LogItem::LogType LogItem::getType() const {
 		return type;
 	}
 
@@ -1454,108 +3281,96 @@ namespace qqwing {
 	 * Print the current log item.  The message used is
 	 * determined by the type of log item.
 	 */
-	void LogItem::print(){
-		cout << "Round: " << getRound() << " - ";
+	void LogItem::print(ostream& out) const {
+		out << "Round: " << getRound() << " - ";
 		switch(type){
 			case GIVEN:{
-				cout << "Mark given";
+				out << "Mark given";
 			} break;
 			case ROLLBACK:{
-				cout << "Roll back round";
+				out << "Roll back round";
 			} break;
 			case GUESS:{
-				cout << "Mark guess (start round)";
+				out << "Mark guess (start round)";
 			} break;
 			case HIDDEN_SINGLE_ROW:{
-				cout << "Mark single possibility for value in row";
+				out << "Mark single possibility for value in row";
 			} break;
 			case HIDDEN_SINGLE_COLUMN:{
-				cout << "Mark single possibility for value in column";
+				out << "Mark single possibility for value in column";
 			} break;
 			case HIDDEN_SINGLE_SECTION:{
-				cout << "Mark single possibility for value in section";
+				out << "Mark single possibility for value in section";
 			} break;
 			case SINGLE:{
-				cout << "Mark only possibility for cell";
+				out << "Mark only possibility for cell";
 			} break;
 			case NAKED_PAIR_ROW:{
-				cout << "Remove possibilities for naked pair in row";
+				out << "Remove possibilities for naked pair in row";
 			} break;
 			case NAKED_PAIR_COLUMN:{
-				cout << "Remove possibilities for naked pair in column";
+				out << "Remove possibilities for naked pair in column";
 			} break;
 			case NAKED_PAIR_SECTION:{
-				cout << "Remove possibilities for naked pair in section";
+				out << "Remove possibilities for naked pair in section";
 			} break;
 			case POINTING_PAIR_TRIPLE_ROW: {
-				cout << "Remove possibilities for row because all values are in one section";
+				out << "Remove possibilities for row because all values are in one section";
 			} break;
 			case POINTING_PAIR_TRIPLE_COLUMN: {
-				cout << "Remove possibilities for column because all values are in one section";
+				out << "Remove possibilities for column because all values are in one section";
 			} break;
 			case ROW_BOX: {
-				cout << "Remove possibilities for section because all values are in one row";
+				out << "Remove possibilities for section because all values are in one row";
 			} break;
 			case COLUMN_BOX: {
-				cout << "Remove possibilities for section because all values are in one column";
+				out << "Remove possibilities for section because all values are in one column";
 			} break;
 			case HIDDEN_PAIR_ROW: {
-				cout << "Remove possibilities from hidden pair in row";
+				out << "Remove possibilities from hidden pair in row";
 			} break;
 			case HIDDEN_PAIR_COLUMN: {
-				cout << "Remove possibilities from hidden pair in column";
+				out << "Remove possibilities from hidden pair in column";
 			} break;
 			case HIDDEN_PAIR_SECTION: {
-				cout << "Remove possibilities from hidden pair in section";
+				out << "Remove possibilities from hidden pair in section";
 			} break;
 			default:{
-				cout << "!!! Performed unknown optimization !!!";
+				out << "!!! Performed unknown optimization !!!";
 			} break;
 		}
 		if (value > 0 || position > -1){
-			cout << " (";
+			out << " (";
 			bool printed = false;
 			if (position > -1){
-				if (printed) cout << " - ";
-				cout << "Row: " << cellToRow(position)+1 << " - Column: " << cellToColumn(position)+1;
+				if (printed) out << " - ";
+				out << "Row: " << cellToRow(position)+1 << " - Column: " << cellToColumn(position)+1;
 				printed = true;
 			}
 			if (value > 0){
-				if (printed) cout << " - ";
-				cout << "Value: " << value;
+				if (printed) out << " - ";
+				out << "Value: " << value;
 				printed = true;
 			}
-			cout << ")";
+			out << ")";
 		}
 	}
 
-	/**
-	 * Given a vector of LogItems, determine how many
-	 * log items in the vector are of the specified type.
-	 */
-	int getLogCount(vector<LogItem*>* v, LogItem::LogType type){
-		unsigned int count = 0;
-		{for (unsigned int i=0; i<v->size(); i++){
-			if(v->at(i)->getType() == type) count++;
-		}}
-		return count;
-	}
-
 	/**
 	 * Shuffle the values in an array of integers.
 	 */
-	void shuffleArray(int* array, int size){
+	void SudokuBoard::shuffleArray(int* array, int size){
 		{for (int i=0; i<size; i++){
 			int tailSize = size-i;
-			int randTailPos = rand()%tailSize+i;
+			int randTailPos = nextRandom()%tailSize+i;
 			int temp = array[i];
 			array[i] = array[randTailPos];
 			array[randTailPos] = temp;
 		}}
 	}
 
-	SudokuBoard::Symmetry getRandomSymmetry(){
-		switch (rand()%4){
+	SudokuBoard::Symmetry SudokuBoard::getRandomSymmetry(){
+		switch (nextRandom()%4){
 			case 0: return SudokuBoard::ROTATE90;
 			case 1: return SudokuBoard::ROTATE180;
 			case 2: return SudokuBoard::MIRROR;
@@ -1624,14 +3439,6 @@ namespace qqwing {
 				+ (section/GRID_SIZE*SEC_GROUP_SIZE);
 	}
 
-	/**
-	 * Given a value for a cell (0-8) and a cell (0-80)
-	 * calculate the offset into the possibility array (0-728).
-	 */
-	static inline int getPossibilityIndex(int valueIndex, int cell){
-		return valueIndex+(ROW_COL_SEC_SIZE*cell);
-	}
-
 	/**
 	 * Given a row (0-8) and a column (0-8) calculate the
 	 * cell (0-80).
@@ -1649,4 +3456,157 @@ namespace qqwing {
 				+ ((offset/GRID_SIZE)*ROW_COL_SEC_SIZE)
 				+ (offset%GRID_SIZE);
 	}
+
+	/**
+	 * Given a value index (0-8) calculate the bit
+	 * that represents it in a candidate mask.
+	 */
+	static inline unsigned short valueIndexToBit(int valueIndex){
+		return (unsigned short)(1<<valueIndex);
+	}
+
+	/**
+	 * Count the number of bits set in a candidate mask.
+	 */
+	static inline int countBits(unsigned int mask){
+		#if defined(__GNUC__)
+			return __builtin_popcount(mask);
+		#else
+			int count = 0;
+			while (mask != 0){
+				mask &= mask-1;
+				count++;
+			}
+			return count;
+		#endif
+	}
+
+	/**
+	 * Given a non-zero candidate mask calculate the
+	 * index (0-8) of the lowest value set in it.
+	 */
+	static inline int lowestBitIndex(unsigned int mask){
+		#if defined(__GNUC__)
+			return __builtin_ctz(mask);
+		#else
+			int index = 0;
+			while ((mask & 1) == 0){
+				mask >>= 1;
+				index++;
+			}
+			return index;
+		#endif
+	}
+
+	/**
+	 * Add a member to a set stored as an array of bits.
+	 */
+	static inline void addToSet(unsigned int* set, int member){
+		set[member/32] |= 1u << (member%32);
+	}
+
+	/**
+	 * Remove a member from a set stored as an array of bits.
+	 */
+	static inline void removeFromSet(unsigned int* set, int member){
+		set[member/32] &= ~(1u << (member%32));
+	}
+
+	/**
+	 * Find the smallest member of a set stored as an array of
+	 * bits that is at least "from", or -1 if there is none.
+	 */
+	static inline int nextInSet(const unsigned int* set, int words, int from){
+		int word = from/32;
+		if (word >= words) return -1;
+		unsigned int bits = set[word] & (~0u << (from%32));
+		while (bits == 0){
+			word++;
+			if (word >= words) return -1;
+			bits = set[word];
+		}
+		return word*32+lowestBitIndex(bits);
+	}
+
+	/**
+	 * Count each bit set in the mask.  The counts are kept for every
+	 * bit of a mask at once, with bit i of each count in counts[i].
+	 */
+	static inline void addToCounts(unsigned int* counts, unsigned int mask){
+		{for (int i=0; i<COUNT_BITS && mask!=0; i++){
+			unsigned int carry = counts[i] & mask;
+			counts[i] ^= mask;
+			mask = carry;
+		}}
+	}
+
+	/**
+	 * The bits for which the counts kept by addToCounts()
+	 * are equal to the given count.
+	 */
+	static inline unsigned int countsEqual(const unsigned int* counts, int count){
+		unsigned int bits = ~0u;
+		{for (int i=0; i<COUNT_BITS; i++){
+			bits &= ((count>>i) & 1) ? counts[i] : ~counts[i];
+		}}
+		return bits;
+	}
+
+	/**
+	 * The type of the same step with rows swapped for columns:
+	 * steps in a row become steps in a column, and the other way
+	 * around.  Other steps stay the same.
+	 */
+	static LogItem::LogType transposeLogType(LogItem::LogType type){
+		switch (type){
+			case LogItem::HIDDEN_SINGLE_ROW: return LogItem::HIDDEN_SINGLE_COLUMN;
+			case LogItem::HIDDEN_SINGLE_COLUMN: return LogItem::HIDDEN_SINGLE_ROW;
+			case LogItem::NAKED_PAIR_ROW: return LogItem::NAKED_PAIR_COLUMN;
+			case LogItem::NAKED_PAIR_COLUMN: return LogItem::NAKED_PAIR_ROW;
+			case LogItem::HIDDEN_PAIR_ROW: return LogItem::HIDDEN_PAIR_COLUMN;
+			case LogItem::HIDDEN_PAIR_COLUMN: return LogItem::HIDDEN_PAIR_ROW;
+			case LogItem::POINTING_PAIR_TRIPLE_ROW: return LogItem::POINTING_PAIR_TRIPLE_COLUMN;
+			case LogItem::POINTING_PAIR_TRIPLE_COLUMN: return LogItem::POINTING_PAIR_TRIPLE_ROW;
+			case LogItem::ROW_BOX: return LogItem::COLUMN_BOX;
+			case LogItem::COLUMN_BOX: return LogItem::ROW_BOX;
+			default: return type;
+		}
+	}
+
+	/**
+	 * Scramble the bits of a word so that words that differ only
+	 * a little give very different results.  Different words
+	 * always give different results.
+	 */
+	static inline unsigned int mixBits(unsigned int x){
+		x ^= x>>16;
+		x *= 0x7FEB352D;
+		x ^= x>>15;
+		x *= 0x846CA68B;
+		x ^= x>>16;
+		return x;
+	}
+
+	PeerSets::PeerSets(){
+		{for (int position=0; position<BOARD_SIZE; position++){
+			{for (int i=0; i<SQUARE_SET_WORDS; i++){
+				squares[position][i] = 0;
+			}}
+			{for (int i=0; i<ROW_COL_SEC_SIZE; i++){
+				addToSet(squares[position], rowColumnToCell(cellToRow(position), i));
+				addToSet(squares[position], rowColumnToCell(i, cellToColumn(position)));
+				addToSet(squares[position], sectionToCell(cellToSection(position), i));
+			}}
+		}}
+	}
+
+	BandPeers::BandPeers(){
+		{for (int square=0; square<SEC_GROUP_SIZE; square++){
+			int row = square/ROW_COL_SEC_SIZE;
+			int column = square%ROW_COL_SEC_SIZE;
+			squares[square] = (BAND_ROW<<(row*ROW_COL_SEC_SIZE))
+					| (BAND_COLUMN<<column)
+					| (BAND_SECTION<<(column/GRID_SIZE*GRID_SIZE));
+		}}
+	}
 }
@@ -29,22 +29,211 @@
 
 		using namespace std;
 
-		class LogItem;
-
 		const int GRID_SIZE = 3;
 		const int ROW_COL_SEC_SIZE = GRID_SIZE*GRID_SIZE;
 		const int SEC_GROUP_SIZE = ROW_COL_SEC_SIZE*GRID_SIZE;
 		const int BOARD_SIZE = ROW_COL_SEC_SIZE*ROW_COL_SEC_SIZE;
 		const int POSSIBILITY_SIZE = BOARD_SIZE*ROW_COL_SEC_SIZE;
 
+		/**
+		 * Rows, columns, and sections are numbered together as units
+		 * when counting the squares left for each value: rows are
+		 * units 0-8, columns 9-17, and sections 18-26.
+		 */
+		const int ROW_UNITS = 0;
+		const int COLUMN_UNITS = ROW_COL_SEC_SIZE;
+		const int SECTION_UNITS = 2*ROW_COL_SEC_SIZE;
+		const int UNIT_COUNT = 3*ROW_COL_SEC_SIZE;
+
+		/**
+		 * Words needed for one bit for each value in each unit.
+		 */
+		const int HIDDEN_SINGLE_WORDS = (UNIT_COUNT*ROW_COL_SEC_SIZE+31)/32;
+
+		/**
+		 * Words needed for one bit for each square on the board.
+		 */
+		const int SQUARE_SET_WORDS = (BOARD_SIZE+31)/32;
+
+		/**
+		 * While solving the puzzle, log steps taken in a log item.
+		 * This is useful for later printing out the solve history
+		 * or gathering statistics about how hard the puzzle was to
+		 * solve.
+		 */
+		class LogItem {
+			public:
+				enum LogType {
+					GIVEN,
+					SINGLE,
+					HIDDEN_SINGLE_ROW,
+					HIDDEN_SINGLE_COLUMN,
+					HIDDEN_SINGLE_SECTION,
+					GUESS,
+					ROLLBACK,
+					NAKED_PAIR_ROW,
+					NAKED_PAIR_COLUMN,
+					NAKED_PAIR_SECTION,
+					POINTING_PAIR_TRIPLE_ROW,
+					POINTING_PAIR_TRIPLE_COLUMN,
+					ROW_BOX,
+					COLUMN_BOX,
+					HIDDEN_PAIR_ROW,
+					HIDDEN_PAIR_COLUMN,
+					HIDDEN_PAIR_SECTION,
+					LOG_TYPE_COUNT
+				};
+				LogItem(int round, LogType type);
+				LogItem(int round, LogType type, int value, int position);
+				int getRound() const;
+				void print(ostream& out) const;
+				LogType getType() const;
+				void transform(const int* newPosition, const int* valueMap, bool transpose);
+			private:
+				void init(int round, LogType type, int value, int position);
+				/**
+				 * The recursion level at which this item was gathered.
+				 * Used for backing out log items solve branches that
+				 * don't lead to a solution.
+				 */
+				int round;
+
+				/**
+				 * The type of log message that will determine the
+				 * message printed.
+				 */
+				LogType type;
+
+				/**
+				 * Value that was set by the operation (or zero for no value)
+				 */
+				int value;
+
+				/**
+				 * position on the board at which the value (if any) was set.
+				 */
+				int position;
+		};
+
+		/**
+		 * One change made to the board while solving, recorded so
+		 * that it can be undone when the round in which it was made
+		 * is rolled back.  Each entry removes at least one possibility,
+		 * so there can never be more than POSSIBILITY_SIZE entries on
+		 * the trail at once.  Entries are kept to four bytes so that
+		 * the whole trail is no bigger than the rest of the board.
+		 */
+		struct TrailEntry {
+			/**
+			 * The round at which the change was made.  Each guess
+			 * fills in a square and uses two rounds, so rounds
+			 * never go past 2+2*BOARD_SIZE and fit in a byte.
+			 */
+			unsigned char round;
+
+			/**
+			 * Position on the board (0-80) that was changed.
+			 */
+			unsigned char position;
+
+			/**
+			 * Candidate bits that were removed from the position.
+			 * When the change filled in the position, these are
+			 * all the candidates it had, and undoing the entry
+			 * empties the square again.
+			 */
+			unsigned short removed;
+		};
+
 		/**
 		 * The version of QQwing, e.g. 1.2.3
 		 */
 		string getVersion();
 
+		/**
+		 * Parse the first puzzle from text: the first 81
+		 * digits and periods, with a period or zero for each
+		 * unknown and anything else ignored.  Returns the
+		 * number of characters up to the end of the puzzle,
+		 * or zero if the text does not have a whole puzzle.
+		 */
+		size_t parsePuzzle(const char* text, size_t length, int* puzzle);
+
+		/**
+		 * A cache of the solutions and solve statistics of
+		 * puzzles, for boards to share with setSolveCache().
+		 * Puzzles are looked up by their canonical form, so a
+		 * puzzle is found if it, or any puzzle that can be turned
+		 * into it by swapping values, rows, columns, and so on,
+		 * has been solved.  When the cache is full, puzzles that
+		 * have not been found in it lately are dropped to make
+		 * room (the CLOCK algorithm).  A cache may be shared by
+		 * boards on one thread only.
+		 */
+		class SolveCache {
+			public:
+				SolveCache(int capacity);
+				int getCapacity() const;
+				int getSize() const;
+				unsigned long getHits() const;
+				unsigned long getMisses() const;
+				void clear();
+			private:
+				friend class SudokuBoard;
+
+				/**
+				 * A puzzle in canonical form, with its solution
+				 * in canonical form and the counts of each type of
+				 * solve instruction and rollback.
+				 */
+				struct Entry {
+					unsigned char puzzle[BOARD_SIZE];
+					unsigned char solution[BOARD_SIZE];
+					bool solved;
+					int instructionCounts[LogItem::LOG_TYPE_COUNT];
+					int rollbackCount;
+
+					/**
+					 * Whether the entry has been found since
+					 * the clock hand last passed it.
+					 */
+					bool referenced;
+
+					/**
+					 * The next entry in the same hash bucket, or -1.
+					 */
+					int next;
+				};
+				Entry* find(const int* canonical);
+				Entry* add(const int* canonical);
+				unsigned int hash(const unsigned char* canonical) const;
+				void unlink(int index);
+
+				vector<Entry> entries;
+				int size;
+
+				/**
+				 * The first entry in each hash bucket, or -1.
+				 */
+				vector<int> buckets;
+
+				/**
+				 * The next entry to consider dropping.
+				 */
+				int hand;
+				unsigned long hits;
+				unsigned long misses;
+		};
+
 		/**
 		 * The board containing all the memory structures and
 		 * methods for solving or generating sudoku puzzles.
+		 * The memory structures are all part of the board
+		 * itself, so boards may be created on the stack or
+		 * in arrays without any memory being allocated for
+		 * them, and may be copied and assigned.  Only the
+		 * solve history grows as needed, and it keeps its
+		 * memory from puzzle to puzzle.
 		 */
 		class SudokuBoard {
 			public:
@@ -69,12 +258,77 @@
 					FLIP,
 					RANDOM
 				};
+
+				/**
+				 * The human solving strategies, in the order
+				 * in which they are tried.
+				 */
+				enum Strategy {
+					ONLY_POSSIBILITY_FOR_CELL,
+					ONLY_VALUE_IN_SECTION,
+					ONLY_VALUE_IN_ROW,
+					ONLY_VALUE_IN_COLUMN,
+					NAKED_PAIRS,
+					POINTING_ROW_REDUCTION,
+					POINTING_COLUMN_REDUCTION,
+					ROW_BOX_REDUCTION,
+					COLUMN_BOX_REDUCTION,
+					HIDDEN_PAIR_IN_ROW,
+					HIDDEN_PAIR_IN_COLUMN,
+					HIDDEN_PAIR_IN_SECTION,
+					STRATEGY_COUNT
+				};
+
+				/**
+				 * All the statistics about how a puzzle was
+				 * solved, as returned by getStats().
+				 */
+				struct Stats {
+					int givenCount;
+					int singleCount;
+					int hiddenSingleCount;
+					int nakedPairCount;
+					int hiddenPairCount;
+					int pointingPairTripleCount;
+					int boxLineReductionCount;
+					int guessCount;
+					int backtrackCount;
+					SudokuBoard::Difficulty difficulty;
+				};
+
+				/**
+				 * What was gathered about the solving strategies
+				 * while profiling.  For each strategy: how many
+				 * times it was tried, how many of those times it
+				 * made progress, and the time spent in it.  Times
+				 * are in ticks of the clock named by
+				 * getProfileTickUnit().
+				 */
+				struct Profile {
+					unsigned long invocations[STRATEGY_COUNT];
+					unsigned long hits[STRATEGY_COUNT];
+					unsigned long long ticks[STRATEGY_COUNT];
+					unsigned long marks;
+					unsigned long rollbacks;
+				};
 				SudokuBoard();
 				bool setPuzzle(int* initPuzzle);
 				const int* getPuzzle();
 				const int* getSolution();
 				void printPuzzle();
+				void printPuzzle(ostream& out);
 				void printSolution();
+				void printSolution(ostream& out);
+
+				/**
+				 * Solve the puzzle.  When history is neither
+				 * recorded nor logged and the solve is not
+				 * profiled, nothing but the solution is needed, so
+				 * a much faster solver that does not use the human
+				 * solving strategies is used instead.  It counts no
+				 * moves, so the statistics such as getSingleCount()
+				 * are all zero afterwards.
+				 */
 				bool solve();
 
 				/**
@@ -108,12 +362,126 @@
 				 * return true if the puzzle has more than one solution
 				 */
 				bool hasMultipleSolutions();
+
+				/**
+				 * return true if the puzzle has a solution other
+				 * than the given one (81 integers, 1-9) that
+				 * differs from it in at least one of the given
+				 * positions.  This only looks for one such
+				 * solution, so it is much faster than counting
+				 * solutions.  When the puzzle with those positions
+				 * filled in from the given solution has only that
+				 * solution, as when they are givens that have just
+				 * been taken out of a puzzle with a unique solution,
+				 * it tells whether the puzzle still has a unique
+				 * solution.
+				 */
+				bool hasSolutionDifferingAt(const int* solution, const int* positions, int positionCount);
 				bool isSolved();
 				void printSolveHistory();
+				void printSolveHistory(ostream& out);
 				void setRecordHistory(bool recHistory);
 				void setLogHistory(bool logHist);
 				void setPrintStyle(PrintStyle ps);
+
+				/**
+				 * Look up puzzles in the given cache (or none, if
+				 * NULL) when solving them with the human solving
+				 * strategies, and add them to it.  A puzzle found
+				 * in the cache gets its solution, statistics, and
+				 * difficulty without being solved again, but no
+				 * solve history.  The statistics are those of the
+				 * first of the puzzles that can be turned into each
+				 * other to be solved.  The cache is not used while
+				 * logging history or profiling.  Solving without
+				 * the strategies is faster than finding the
+				 * canonical form, so those solves are not cached.
+				 */
+				void setSolveCache(SolveCache* cache);
+				SolveCache* getSolveCache();
+
+				/**
+				 * Seed the random number generator used to generate
+				 * puzzles and to pick guesses while solving.  Each
+				 * board has its own generator, seeded from the clock
+				 * when the board is created.  All of the board's
+				 * random state starts over, so a board that has
+				 * already been used and a new board, given the same
+				 * seed and then the same calls, give the same results.
+				 */
+				void setSeed(unsigned long seed);
+
+				/**
+				 * Turn profiling of the solving strategies on or
+				 * off.  The profile adds up over every puzzle
+				 * solved or generated until it is cleared.  While
+				 * profiling, solve() always uses the human solving
+				 * strategies, so that there is something to profile.
+				 * When profiling is off, gathering the profile
+				 * costs one untaken branch for each solving step.
+				 */
+				void setProfile(bool profile);
+				const SudokuBoard::Profile& getProfile();
+				void clearProfile();
+
+				/**
+				 * The name of a strategy, e.g. "Hidden Pair in Row"
+				 */
+				static const char* getStrategyName(SudokuBoard::Strategy strategy);
+
+				/**
+				 * The unit of the times in the profile:
+				 * "cycles" or "nanoseconds"
+				 */
+				static const char* getProfileTickUnit();
 				bool generatePuzzle();
+
+				/**
+				 * Fill in the given array of 81 integers with a
+				 * random, completely filled in, valid Sudoku grid.
+				 * The board itself is not changed, other than using
+				 * its random numbers.
+				 */
+				void generateSolutionGrid(int* grid);
+
+				/**
+				 * Turn the puzzle into a random one of the puzzles
+				 * that are the same but for swapping the values, rows
+				 * within each band, bands, columns within each stack,
+				 * stacks, or rows with columns.  These can all be
+				 * solved with the same steps, so the solution and
+				 * solve history are changed along with the puzzle,
+				 * and the statistics and difficulty stay the same,
+				 * without solving again.
+				 * The possibilities used by the solving strategies are
+				 * not changed; they are worked out again the next
+				 * time the puzzle is solved.
+				 */
+				void transformRandomly();
+
+				/**
+				 * Find the canonical form of the given puzzle (81
+				 * integers, 0 for unknowns): the smallest, read
+				 * square by square, of all the puzzles it can be
+				 * turned into by swapping values, rows within each
+				 * band, bands, columns within each stack, stacks,
+				 * or rows with columns.  Two puzzles have the same
+				 * canonical form exactly when one can be turned
+				 * into the other in this way.  A puzzle with
+				 * conflicting givens has no canonical form: false
+				 * is returned and canonical is filled with zeros.
+				 */
+				static bool getCanonicalForm(const int* puzzle, int* canonical);
+
+				/**
+				 * Find the canonical form of the given puzzle, and
+				 * how it was found: square i of the canonical form
+				 * is valueMap[puzzle[cellMap[i]]].  valueMap has
+				 * ten entries, and valueMap[0] is 0.  Returns false,
+				 * leaving cellMap and valueMap unset, when the
+				 * givens conflict.
+				 */
+				static bool getCanonicalForm(const int* puzzle, int* canonical, int* cellMap, int* valueMap);
 				bool generatePuzzleSymmetry(SudokuBoard::Symmetry symmetry);
 				int getGivenCount();
 				int getSingleCount();
@@ -124,46 +492,136 @@
 				int getPointingPairTripleCount();
 				int getGuessCount();
 				int getBacktrackCount();
+
+				/**
+				 * Get every one of the counts above, and the
+				 * difficulty, with a single call.  The counts are
+				 * kept up to date while solving, so this is as
+				 * cheap as calling any one of them.
+				 */
+				SudokuBoard::Stats getStats();
 				void printSolveInstructions();
+				void printSolveInstructions(ostream& out);
 				SudokuBoard::Difficulty getDifficulty();
 				string getDifficultyAsString();
-				~SudokuBoard();
+
+				/**
+				 * The name of a difficulty, e.g. "Intermediate"
+				 */
+				static const char* getDifficultyName(SudokuBoard::Difficulty difficulty);
 
 			private:
+				/**
+				 * The strategies that keep a worklist of the parts of the board
+				 * they need to look at again.  When a strategy looks at part of
+				 * the board and finds nothing to do there, that part is taken off
+				 * its worklist until a possibility in it is removed or restored.
+				 * Parts of the board are numbered in the order the strategy looks
+				 * at them, so the first one that leads to a move is the same as if
+				 * the whole board had been searched.
+				 */
+				enum Worklist {
+					NAKED_PAIR_WORK, // square (0-80)
+					POINTING_ROW_WORK, // valIndex*9+section
+					POINTING_COLUMN_WORK, // valIndex*9+section
+					ROW_BOX_WORK, // valIndex*9+row
+					COLUMN_BOX_WORK, // valIndex*9+column
+					HIDDEN_PAIR_ROW_WORK, // row (0-8)
+					HIDDEN_PAIR_COLUMN_WORK, // column (0-8)
+					HIDDEN_PAIR_SECTION_WORK, // section (0-8)
+					WORKLIST_COUNT
+				};
+
 				/**
 				 * The 81 integers that make up a sudoku puzzle.
 				 * Givens are 1-9, unknowns are 0.
 				 * Once initialized, this puzzle remains as is.
 				 * The answer is worked out in "solution".
 				 */
-				int* puzzle;
+				int puzzle[BOARD_SIZE];
 
 				/**
 				 * The 81 integers that make up a sudoku puzzle.
 				 * The solution is built here, after completion
 				 * all will be 1-9.
 				 */
-				int* solution;
+				int solution[BOARD_SIZE];
+
+				/**
+				 * The 81 candidate masks, one for each square.
+				 * Bit n of candidates[i] is set when the value
+				 * n+1 could still be filled in to square i
+				 * according to the Sudoku rules.  Squares that
+				 * have been filled in have no candidates.
+				 */
+				unsigned short candidates[BOARD_SIZE];
+
+				/**
+				 * The changes made to candidates and solution
+				 * while solving, most recent last.  Each entry
+				 * records the round (recursion level) at which it
+				 * was made, so that solve branches that don't lead
+				 * to a solution can be backed out by popping just
+				 * the entries for that round.
+				 */
+				TrailEntry trail[POSSIBILITY_SIZE];
+
+				/**
+				 * The number of entries currently on the trail.
+				 */
+				int trailSize;
+
+				/**
+				 * For each of the 27 rows, columns, and sections
+				 * and each value in it, the number of squares in
+				 * that row, column, or section for which the value
+				 * is still a possibility.
+				 */
+				unsigned char unitValueCounts[UNIT_COUNT*ROW_COL_SEC_SIZE];
+
+				/**
+				 * A bit for each entry in unitValueCounts that is
+				 * exactly one.  Each of these is a hidden single
+				 * waiting to be marked.
+				 */
+				unsigned int hiddenSingles[HIDDEN_SINGLE_WORDS];
+
+				/**
+				 * The set of squares that have not been filled in
+				 * and have exactly one possibility left.
+				 */
+				unsigned int nakedSingles[SQUARE_SET_WORDS];
+
+				/**
+				 * For each strategy that looks for pairs or for
+				 * values confined to a box or line, the set of
+				 * places on the board it still needs to look at.
+				 * Only places where possibilities changed since the
+				 * strategy last looked need to be looked at again.
+				 */
+				unsigned int worklists[WORKLIST_COUNT*SQUARE_SET_WORDS];
+
+				/**
+				 * For each square, the values whose possibilities
+				 * changed since the worklists were last updated.
+				 */
+				unsigned short pendingChanges[BOARD_SIZE];
 
 				/**
-				 * Recursion depth at which each of the numbers
-				 * in the solution were placed.  Useful for backing
-				 * out solve branches that don't lead to a solution.
+				 * The set of squares with pending changes.
 				 */
-				int* solutionRound;
+				unsigned int changedSquares[SQUARE_SET_WORDS];
 
 				/**
-				 * The 729 integers that make up a the possible
-				 * values for a Sudoku puzzle. (9 possibilities
-				 * for each of 81 squares).  If possibilities[i]
-				 * is zero, then the possibility could still be
-				 * filled in according to the Sudoku rules.  When
-				 * a possibility is eliminated, possibilities[i]
-				 * is assigned the round (recursion level) at
-				 * which it was determined that it could not be
-				 * a possibility.
+				 * The number of squares that have been filled in.
 				 */
-				int* possibilities;
+				int solvedCount;
+
+				/**
+				 * The number of squares that have not been filled
+				 * in, but have no possibilities left.
+				 */
+				int emptyCount;
 
 				/**
 				 * An array the size of the board (81) containing each
@@ -171,14 +629,20 @@
 				 * be shuffled so that operations that need to
 				 * look at each cell can do so in a random order.
 				 */
-				int* randomBoardArray;
+				int randomBoardArray[BOARD_SIZE];
 
 				/**
 				 * An array with one element for each position (9), in
 				 * some random order to be used when trying each
 				 * position in turn during guesses.
 				 */
-				int* randomPossibilityArray;
+				int randomPossibilityArray[ROW_COL_SEC_SIZE];
+
+				/**
+				 * The four words of state for the random number
+				 * generator (xoshiro128**) of this board.
+				 */
+				unsigned int randomState[4];
 
 				/**
 				 * Whether or not to record history
@@ -194,35 +658,74 @@
 				 * A list of moves used to solve the puzzle.
 				 * This list contains all moves, even on solve
 				 * branches that did not lead to a solution.
+				 * The moves are kept by value and the list is
+				 * only cleared between puzzles, so its memory
+				 * is reused from one puzzle to the next.
 				 */
-				vector<LogItem*>* solveHistory;
+				vector<LogItem> solveHistory;
 
 				/**
-				 * A list of moves used to solve the puzzle.
-				 * This list contains only the moves needed
-				 * to solve the puzzle, but doesn't contain
-				 * information about bad guesses.
+				 * The indexes into solveHistory of the moves
+				 * needed to solve the puzzle.  This list doesn't
+				 * contain information about bad guesses.
+				 */
+				vector<int> solveInstructions;
+
+				/**
+				 * For each type of log item, the number of
+				 * items of that type in solveInstructions.
 				 */
-				vector<LogItem*>* solveInstructions;
+				int instructionCounts[LogItem::LOG_TYPE_COUNT];
+
+				/**
+				 * The number of rollbacks in solveHistory.
+				 */
+				int rollbackCount;
 
 				/**
 				 * The style with which to print puzzles and solutions
 				 */
 				PrintStyle printStyle;
 
+				/**
+				 * Whether or not to gather the profile
+				 */
+				bool profiling;
+
+				/**
+				 * The profile gathered so far
+				 */
+				Profile profile;
+
+				/**
+				 * The cache of solved puzzles, or NULL
+				 */
+				SolveCache* solveCache;
+
 				/**
 				 * The last round of solving
 				 */
 				int lastSolveRound;
 				bool reset();
+				bool resetByMarking();
+				void resetWorklists();
+				void clearHistory();
+				unsigned int nextRandom();
+				void shuffleArray(int* array, int size);
+				bool randomTransformation(int* cellMap, int* valueMap);
+				SudokuBoard::Symmetry getRandomSymmetry();
+				bool solveWithStrategies();
+				bool solveWithBitboards();
+				bool solveWithCache();
 				bool singleSolveMove(int round);
+				bool profiledSingleSolveMove(int round);
+				bool applyStrategy(int strategy, int round);
 				bool onlyPossibilityForCell(int round);
 				bool onlyValueInRow(int round);
 				bool onlyValueInColumn(int round);
 				bool onlyValueInSection(int round);
 				bool solve(int round);
 				int countSolutions(bool limitToTwo);
-				int countSolutions(int round, bool limitToTwo);
 				bool guess(int round, int guessNumber);
 				bool isImpossible();
 				void rollbackRound(int round);
@@ -238,13 +741,102 @@
 				bool handleNakedPairs(int round);
 				int countPossibilities(int position);
 				bool arePossibilitiesSame(int position1, int position2);
-				void addHistoryItem(LogItem* l);
+				bool isPossible(int position, int valIndex);
+				bool eliminatePossibility(int position, int valIndex, int round);
+				void pushTrailEntry(int round, int position, unsigned short removed);
+				void undoTrailEntry(const TrailEntry& entry);
+				int findHiddenSingle(int firstUnit);
+				void removeFromUnitCounts(int position, int valIndex);
+				void restoreToUnitCounts(int position, int valIndex);
+				void decrementUnitValueCount(int unit, int valIndex);
+				void incrementUnitValueCount(int unit, int valIndex);
+				int nextUnchecked(int worklist, int from);
+				void checked(int worklist, int item);
+				void possibilitiesChanged(int position, unsigned int changed);
+				void updateWorklists();
+				void addToWorklists(int position, unsigned int changed);
+				void addHistoryItem(const LogItem& l);
 				void shuffleRandomArrays();
-				void print(int* sudoku);
-				void rollbackNonGuesses();
+				void print(ostream& out, int* sudoku);
 				void clearPuzzle();
-				void printHistory(vector<LogItem*>* v);
+				void printHistory(ostream& out, bool instructionsOnly);
 				bool removePossibilitiesInOneFromTwo(int position1, int position2, int round);
 		};
+
+		/**
+		 * The binary puzzle file format, for large banks of
+		 * puzzles that would be slow to parse and format as
+		 * text.  A file is an eight byte header followed by
+		 * fixed size records.  The header is the characters
+		 * "QQWB", the format version, flags saying whether each
+		 * record has a solution (1) and stats (2), and the size
+		 * of each record as two bytes, low byte first.  Each
+		 * record is the puzzle, packed two squares to a byte
+		 * (the first square in the high four bits, zero for
+		 * unknown) into 41 bytes, then the solution packed the
+		 * same way (all zeros when there is none), then the
+		 * stats: the nine counts from getStats() as two bytes
+		 * each, low byte first and at most 65535, and the
+		 * difficulty as one byte.
+		 */
+		const int BINARY_HEADER_SIZE = 8;
+		const int BINARY_FORMAT_VERSION = 1;
+		const int BINARY_BOARD_SIZE = (BOARD_SIZE+1)/2;
+		const int BINARY_STATS_SIZE = 19;
+
+		/**
+		 * Writes puzzles in the binary puzzle file format.
+		 * The header is written separately from the records,
+		 * so that records may be formatted in pieces (on
+		 * several threads, for example) and then put together.
+		 */
+		class BinaryPuzzleWriter {
+			public:
+				BinaryPuzzleWriter(bool solutions, bool stats);
+				int getRecordSize() const;
+				void writeHeader(ostream& out) const;
+
+				/**
+				 * Write one record.  The solution and stats are
+				 * written as zeros when NULL, and are ignored when
+				 * the file does not have them.
+				 */
+				void write(ostream& out, const int* puzzle, const int* solution, const SudokuBoard::Stats* stats) const;
+			private:
+				bool solutions;
+				bool stats;
+		};
+
+		/**
+		 * Reads puzzles in the binary puzzle file format
+		 * from a stream, one record at a time.
+		 */
+		class BinaryPuzzleReader {
+			public:
+				/**
+				 * Read the header from the stream, throwing an
+				 * error if it is not a binary puzzle file.  An
+				 * empty stream has no puzzles.
+				 */
+				BinaryPuzzleReader(istream& in);
+				bool hasSolutions() const;
+				bool hasStats() const;
+				int getRecordSize() const;
+
+				/**
+				 * Read the next record.  Any of the arrays for
+				 * the puzzle, solution, and stats may be NULL when
+				 * not wanted, and the solution and stats are zeros
+				 * when the file does not have them.  Returns false
+				 * at the end of the stream.
+				 */
+				bool read(int* puzzle, int* solution, SudokuBoard::Stats* stats);
+			private:
+				istream& in;
+				bool solutions;
+				bool stats;
+				int recordSize;
+				vector<unsigned char> record;
+		};
 	}
 #endif
@@ -0,0 +1,39 @@
+#!/bin/sh
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+set -e
+set -o pipefail
+
+# Skip for versions without --seed
+if ! $QQWING --help | grep seed > /dev/null
+then
+	exit 0
+fi
+
+expected="Seed expected to be a number, not foo"
+actual=`$QQWING --generate --seed foo 2>&1 || true`
+
+if [ "$expected" != "$actual" ]
+then
+	echo
+	echo "Test: $0"
+	echo "qqwing: $QQWING"
+	echo "Expected: $expected"
+	echo "Actual:   $actual"
+	exit 1
+fi
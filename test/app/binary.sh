@@ -0,0 +1,50 @@
+#!/bin/sh
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+set -e
+set -o pipefail
+
+# Skip for versions without --out-format
+if ! $QQWING --help | grep out-format > /dev/null
+then
+	exit 0
+fi
+
+puzzles=`$QQWING --generate 5 --one-line`
+expected=`echo "$puzzles" | $QQWING --solve --one-line --stats --csv --seed 1`
+
+# Puzzles written in the binary format and read back in
+# solve the same way as the puzzles read as text (seeded,
+# so that any guesses are the same)
+actual=`echo "$puzzles" | $QQWING --solve --nosolution --out-format bin | $QQWING --solve --in-format bin --one-line --stats --csv --seed 1`
+
+# A header and 41 bytes for each puzzle, plus 41 for each
+# solution and 19 for the stats of each when they are written
+size=`echo "$puzzles" | $QQWING --solve --nosolution --out-format bin | wc -c`
+fullSize=`echo "$puzzles" | $QQWING --solve --stats --out-format bin | wc -c`
+
+if [ "$actual" != "$expected" ] || [ $size != 213 ] || [ $fullSize != 513 ]
+then
+	echo
+	echo "Test: $0"
+	echo "qqwing: $QQWING"
+	echo "Expected: $expected"
+	echo "Actual:   $actual"
+	echo "Sizes:    $size $fullSize"
+	exit 1
+fi
@@ -0,0 +1,67 @@
+#!/bin/sh
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+set -e
+set -o pipefail
+
+# Skip for versions without --cache
+if ! $QQWING --help | grep cache > /dev/null
+then
+	exit 0
+fi
+
+# The same puzzle twice, and then with the ones and twos swapped
+puzzle='9..6...7...1..428.7..2.............81.8....45.9..4.6....7.9.5.....4.5....1..6..29'
+swapped=`echo "$puzzle" | tr 12 21`
+actual=`printf "$puzzle\n$puzzle\n$swapped\n" | $QQWING --solve --one-line --stats --csv --cache 10`
+counts=`printf "$puzzle\n$puzzle\n$swapped\n" | $QQWING --solve --one-line --stats --csv --cache 10 --timer | tail -1`
+solution=`echo "$puzzle" | $QQWING --solve --one-line`
+stats=`echo "$puzzle" | $QQWING --solve --one-line --stats --csv | tail -1 | cut -d, -f2-`
+
+expected="Solution,Givens,Singles,Hidden Singles,Naked Pairs,Hidden Pairs,Pointing Pairs/Triples,Box/Line Intersections,Guesses,Backtracks,Difficulty
+$solution,$stats
+$solution,$stats
+`echo "$solution" | tr 12 21`,$stats"
+
+if [ "$actual" != "$expected" ] || [ "$counts" != "Solve cache hits: 2, misses: 1" ]
+then
+	echo
+	echo "Test: $0"
+	echo "qqwing: $QQWING"
+	echo "Expected: $expected"
+	echo "Actual:   $actual"
+	echo "Counts:   $counts"
+	exit 1
+fi
+
+# Conflicting givens are solved without the cache, every time
+conflicting='11...............................................................................'
+actual=`printf "$conflicting\n$conflicting\n" | $QQWING --solve --one-line --stats --csv --cache 10`
+expected=`printf "$conflicting\n$conflicting\n" | $QQWING --solve --one-line --stats --csv`
+counts=`printf "$conflicting\n$conflicting\n" | $QQWING --solve --one-line --stats --csv --cache 10 --timer | tail -1`
+
+if [ "$actual" != "$expected" ] || [ "$counts" != "Solve cache hits: 0, misses: 0" ]
+then
+	echo
+	echo "Test: $0"
+	echo "qqwing: $QQWING"
+	echo "Expected: $expected"
+	echo "Actual:   $actual"
+	echo "Counts:   $counts"
+	exit 1
+fi
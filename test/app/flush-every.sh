@@ -0,0 +1,42 @@
+#!/bin/sh
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+set -e
+set -o pipefail
+
+# Skip for versions without --flush-every
+if ! $QQWING --help | grep flush-every > /dev/null
+then
+	exit 0
+fi
+
+# How often the output is written does not change it
+expected=`$QQWING --generate 20 --solution --stats --csv --seed 1`
+everyPuzzle=`$QQWING --generate 20 --solution --stats --csv --seed 1 --flush-every 1`
+atEnd=`$QQWING --generate 20 --solution --stats --csv --seed 1 --flush-every 0`
+
+if [ "$everyPuzzle" != "$expected" ] || [ "$atEnd" != "$expected" ]
+then
+	echo
+	echo "Test: $0"
+	echo "qqwing: $QQWING"
+	echo "Expected:    $expected"
+	echo "Every:       $everyPuzzle"
+	echo "At the end:  $atEnd"
+	exit 1
+fi
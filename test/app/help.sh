@@ -19,13 +19,18 @@
 set -e
 set -o pipefail
 
-actual=`$QQWING --help | grep -v threads`
+actual=`$QQWING --help`
 expected="qqwing <options>
 Sudoku solver and generator.
   --generate <num>     Generate new puzzles
   --solve              Solve all the puzzles from standard input
   --difficulty <diff>  Generate only simple, easy, intermediate, expert, or any
   --symmetry <sym>     Symmetry: none, rotate90, rotate180, mirror, flip, or random
+  --variants <num>     Also print this many random variants of each generated puzzle
+  --unique             Generate no two puzzles that can be turned into each other
+  --nounique           Generate puzzles without checking for repeats (default)
+  --threads <num>      Generate or solve puzzles using the given number of threads
+  --seed <num>         Seed the random numbers so that runs can be repeated
   --puzzle             Print the puzzle (default when generating)
   --nopuzzle           Do not print the puzzle (default when solving)
   --solution           Print the solution (default when solving)
@@ -42,14 +47,31 @@ Sudoku solver and generator.
   --noinstructions     Do not print steps to solve (default)
   --log-history        Print trial and error to solve as it happens
   --nolog-history      Do not print trial and error  to solve as it happens
+  --cache <num>        Keep the solutions and stats of this many puzzles to reuse
+  --profile            Print how often each solving strategy was tried and the time taken
+  --noprofile          Do not print the solving strategy profile (default)
   --one-line           Print puzzles on one line of 81 characters
   --compact            Print puzzles on 9 lines of 9 characters
   --readable           Print puzzles in human readable form (default)
   --csv                Output CSV format with one line puzzles
+  --input <file>       Read the puzzles to solve from a file, not standard input
+  --in-format <fmt>    Read puzzles as text (default) or bin
+  --flush-every <num>  Write the output after this many puzzles (default 1 on a terminal)
+  --out-format <fmt>   Write puzzles as text (default) or bin
   --help               Print this message
   --about              Author and license information
   --version            Display current version number"
 
+# The other versions don't have the newer options, and the Java
+# version describes --threads its own way, so compare only the
+# lines they share.  The C++ version is checked line for line.
+if ! $QQWING --help | grep seed > /dev/null
+then
+	cpponly='^  --(variants|unique|nounique|threads|seed|cache|profile|noprofile|input|in-format|flush-every|out-format) '
+	actual=`echo "$actual" | grep -v threads`
+	expected=`echo "$expected" | grep -E -v "$cpponly"`
+fi
+
 if [ "$actual" != "$expected" ]
 then
 	actualfile=`mktemp /tmp/actual.XXXXXXXXX`
@@ -0,0 +1,88 @@
+#!/usr/bin/perl
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+# Reads puzzles printed with --one-line --history from standard input
+# and plays each history back against the puzzle printed above it,
+# checking that every square filled in could only have been filled in
+# the way the history says.  Only givens, singles, and hidden singles
+# are understood, so the puzzles must be no harder than easy.
+
+use strict;
+
+my $puzzle = "";
+my @board;
+my $steps = 0;
+while (my $line = <STDIN>){
+	chomp $line;
+	if ($line =~ /^[1-9\.]{81}$/){
+		&finish();
+		$puzzle = $line;
+		@board = (0) x 81;
+		$steps = 0;
+	} elsif ($line =~ /Mark (.*) \(Row: ([1-9]) - Column: ([1-9]) - Value: ([1-9])\)/){
+		my ($step, $row, $column, $value) = ($1, $2-1, $3-1, $4);
+		die "\nHistory without a puzzle: $line" if ($puzzle eq "");
+		my $position = $row*9+$column;
+		die "\nSquare already filled in for $puzzle: $line" if ($board[$position]);
+		if ($step eq "given"){
+			die "\nNot a given of $puzzle: $line" if (substr($puzzle, $position, 1) ne $value);
+		} elsif ($step eq "only possibility for cell"){
+			for my $other (1..9){
+				die "\nNot the only possibility for the cell in $puzzle: $line" if ($other != $value && &possible($position, $other));
+			}
+		} elsif ($step =~ /^single possibility for value in (row|column|section)$/){
+			for my $other (&unit($1, $row, $column)){
+				die "\nNot the only possibility in the $1 in $puzzle: $line" if ($other != $position && &possible($other, $value));
+			}
+		} else {
+			die "\nUnknown step for $puzzle: $line";
+		}
+		die "\nNot possible in $puzzle: $line" if (!&possible($position, $value));
+		$board[$position] = $value;
+		$steps++;
+	} elsif ($line =~ /Round/){
+		die "\nUnexpected step for $puzzle: $line";
+	}
+}
+&finish();
+
+sub finish(){
+	return if ($puzzle eq "");
+	die "\nHistory does not fill in all of $puzzle" if ($steps != 81);
+}
+
+sub unit(){
+	my ($type, $row, $column) = @_;
+	return map {$row*9+$_} (0..8) if ($type eq "row");
+	return map {$_*9+$column} (0..8) if ($type eq "column");
+	my $start = int($row/3)*27+int($column/3)*3;
+	return map {$start+int($_/3)*9+$_%3} (0..8);
+}
+
+sub possible(){
+	my ($position, $value) = @_;
+	return 0 if ($board[$position]);
+	my $row = int($position/9);
+	my $column = $position%9;
+	for my $type ("row", "column", "section"){
+		for my $other (&unit($type, $row, $column)){
+			return 0 if ($board[$other] == $value);
+		}
+	}
+	return 1;
+}
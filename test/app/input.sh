@@ -0,0 +1,53 @@
+#!/bin/sh
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+set -e
+set -o pipefail
+
+# Skip for versions without --input
+if ! $QQWING --help | grep -- --input > /dev/null
+then
+	exit 0
+fi
+
+# Puzzles spread over several lines, ending part way through one
+inputfile=`mktemp /tmp/input.XXXXXXXXX`
+$QQWING --generate 300 --compact > "$inputfile"
+printf "1.2.3" >> "$inputfile"
+
+expected=`$QQWING --solve --one-line < "$inputfile"`
+actual=`$QQWING --solve --one-line --input "$inputfile"`
+
+# With threads, the input is split between them
+threaded="$expected"
+if $QQWING --help | grep threads > /dev/null
+then
+	threaded=`$QQWING --solve --one-line --threads 3 --input "$inputfile"`
+fi
+rm -f "$inputfile"
+
+if [ "$actual" != "$expected" ] || [ "$threaded" != "$expected" ] || [ `echo "$actual" | wc -l` != 300 ]
+then
+	echo
+	echo "Test: $0"
+	echo "qqwing: $QQWING"
+	echo "Expected: $expected"
+	echo "Actual:   $actual"
+	echo "Threaded: $threaded"
+	exit 1
+fi
@@ -0,0 +1,40 @@
+#!/bin/sh
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+set -e
+set -o pipefail
+
+# Skip for versions without profiling
+if ! $QQWING --help | grep profile > /dev/null
+then
+	exit 0
+fi
+
+profile=`echo ".9..4...7..2.61.3..6..839.1274.....8.......9.......2....7......3.....86481......9" | $QQWING --solve --nosolution --profile --csv | grep -v "^Strategy," | grep -v "^$"`
+
+# The puzzle is solved with singles alone: one mark
+# for each of the 55 squares that are not given.
+if [ `echo "$profile" | wc -l` != 14 ] || ! echo "$profile" | grep -q "^Single,55,55," || ! echo "$profile" | grep -q "^Naked Pair,0,0,0$" || ! echo "$profile" | grep -q "^Marks,55$" || ! echo "$profile" | grep -q "^Rollbacks,0$"
+then
+	echo
+	echo "Unexpected profile"
+	echo "qqwing: $QQWING"
+	echo "test: $0"
+	echo "Profile: $profile"
+	exit 1
+fi
@@ -0,0 +1,41 @@
+#!/bin/sh
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+set -e
+set -o pipefail
+
+# The puzzle from solve-easy.sh, as printed with --readable,
+# and then a puzzle with zeros for unknowns and other
+# characters mixed in
+test/app/helper/solve.sh $0 \
+	" 9 6 . | . 3 . | . . 8
+ . . . | 7 . . | 6 4 .
+ 8 . 7 | . . . | . . .
+-------|-------|-------
+ 7 . . | . . . | 8 . 5
+ 5 . 6 | . 7 . | . 1 9
+ . 3 9 | . 8 . | . 6 7
+-------|-------|-------
+ . 9 8 | 1 . . | . . .
+ . . . | . . . | . 3 .
+ 6 . . | . . . | 9 . ." \
+	"962435178153798642847612593714963825586274319239581467398126754471859236625347981"
+
+test/app/helper/solve.sh $0 \
+	"puzzle: 9600300080007006408070000007000008055060 70019039080067098100000000000030600000900 (easy)" \
+	"962435178153798642847612593714963825586274319239581467398126754471859236625347981"
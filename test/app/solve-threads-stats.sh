@@ -0,0 +1,46 @@
+#!/bin/sh
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+set -e
+set -o pipefail
+
+# Skip when built without thread support or --seed, and for
+# the Java version, which prints puzzles in the order solved
+if [ "$QQWINGTESTTYPE" == "java" ] || ! $QQWING --help | grep threads > /dev/null || ! $QQWING --help | grep seed > /dev/null
+then
+	exit 0
+fi
+
+# Hard puzzles that need guesses, more than one batch of them
+puzzles=`for i in 1 2 3 4 5 6; do cat test/bench/hardest.txt test/bench/17-clue.txt; done | grep -v '^#'`
+
+# With a seed, the guesses and the stats that depend on
+# them are the same whatever the number of threads
+expected=`echo "$puzzles" | $QQWING --solve --one-line --stats --csv --seed 9`
+for threads in 2 3 7
+do
+	actual=`echo "$puzzles" | $QQWING --solve --one-line --stats --csv --seed 9 --threads $threads`
+	if [ "$expected" != "$actual" ]
+	then
+		echo
+		echo "Test: $0"
+		echo "qqwing: $QQWING"
+		echo "Solving with $threads threads did not give the same stats"
+		exit 1
+	fi
+done
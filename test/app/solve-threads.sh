@@ -0,0 +1,41 @@
+#!/bin/sh
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+set -e
+set -o pipefail
+
+# Skip when built without thread support, and for the
+# Java version, which prints puzzles in the order solved
+if [ "$QQWINGTESTTYPE" == "java" ] || ! $QQWING --help | grep threads > /dev/null
+then
+	exit 0
+fi
+
+# Solving with threads must give the same output, in the same order
+puzzles=`$QQWING --generate 600 --one-line --seed 1`
+expected=`echo "$puzzles" | $QQWING --solve --one-line --count-solutions`
+actual=`echo "$puzzles" | $QQWING --solve --one-line --count-solutions --threads 3`
+
+if [ "$expected" != "$actual" ]
+then
+	echo
+	echo "Test: $0"
+	echo "qqwing: $QQWING"
+	echo "Solving with threads did not give the same output"
+	exit 1
+fi
@@ -0,0 +1,43 @@
+#!/bin/sh
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+set -e
+set -o pipefail
+
+# Skip for versions without --unique
+if ! $QQWING --help | grep unique > /dev/null
+then
+	exit 0
+fi
+
+puzzles=`$QQWING --generate 10 --unique --one-line`
+
+if [ `echo "$puzzles" | sort -u | wc -l` != 10 ]
+then
+	echo
+	echo "Expected ten different puzzles"
+	echo "qqwing: $QQWING"
+	echo "test: $0"
+	echo "Puzzles: $puzzles"
+	exit 1
+fi
+
+for puzzle in $puzzles
+do
+	./test/app/helper/generate.sh $0 "" "$puzzle"
+done
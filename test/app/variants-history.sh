@@ -0,0 +1,42 @@
+#!/bin/sh
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+set -e
+set -o pipefail
+
+# Skip for versions without --variants
+if ! $QQWING --help | grep variants > /dev/null
+then
+	exit 0
+fi
+
+# Half of the variants have rows swapped with columns, and
+# easy puzzles are solved with hidden singles in rows and
+# columns, so some of the steps change from one to the other.
+output=`$QQWING --generate 5 --variants 4 --difficulty easy --history --one-line`
+
+# Each history must solve the puzzle or variant above it,
+# one step at a time, the way it says.
+if ! echo "$output" | test/app/helper/replay-history.pl
+then
+	echo
+	echo "History does not solve the puzzle"
+	echo "qqwing: $QQWING"
+	echo "test: $0"
+	exit 1
+fi
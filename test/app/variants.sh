@@ -0,0 +1,74 @@
+#!/bin/sh
+# qqwing - Sudoku solver and generator
+# Copyright (C) 2014 Stephen Ostermiller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+set -e
+set -o pipefail
+
+# Skip for versions without --variants
+if ! $QQWING --help | grep variants > /dev/null
+then
+	exit 0
+fi
+
+output=`$QQWING --generate 2 --variants 3 --solution --stats --csv | grep -v "^Puzzle,"`
+
+if [ `echo "$output" | wc -l` != 8 ]
+then
+	echo
+	echo "Expected each puzzle followed by three variants"
+	echo "qqwing: $QQWING"
+	echo "test: $0"
+	echo "Output: $output"
+	exit 1
+fi
+
+# Each variant is a puzzle with a unique solution, and
+# the solution printed for it is that solution.
+for line in $output
+do
+	puzzle=`echo "$line" | cut -d, -f1`
+	solution=`echo "$line" | cut -d, -f2`
+	./test/app/helper/generate.sh $0 "" "$puzzle"
+	solved=`echo "$puzzle" | $QQWING --solve --one-line`
+	if [ "$solved" != "$solution" ]
+	then
+		echo
+		echo "Variant does not have the solution printed for it"
+		echo "qqwing: $QQWING"
+		echo "test: $0"
+		echo "Variant: $line"
+		echo "Solved:  $solved"
+		exit 1
+	fi
+done
+
+# The variants can be solved with the same steps as the
+# puzzle they came from, so they have the same stats.
+for first in 1 5
+do
+	stats=`echo "$output" | sed -n "$first,$((first+3))p" | cut -d, -f3- | sort -u`
+	if [ `echo "$stats" | wc -l` != 1 ]
+	then
+		echo
+		echo "Variants do not have the same stats"
+		echo "qqwing: $QQWING"
+		echo "test: $0"
+		echo "Output: $output"
+		exit 1
+	fi
+done